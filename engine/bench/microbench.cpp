@@ -0,0 +1,514 @@
+// Microbenchmarks for the core kernels: slider attack lookups, move
+// generation, make/unmake, evaluation, hashing and FEN parsing.
+//
+// Every kernel is calibrated so that one sample runs for at least --min-ms,
+// then timed for --warmup discarded samples and --repeats measured ones. The
+// report gives nanoseconds per operation (min, p10, median, p90, max). With
+// --compare, medians are checked against a baseline written earlier with
+// --format csv or json, and the exit status is 1 if any kernel got slower by
+// more than --threshold percent.
+
+#include "core/init.h"
+#include "core/position.h"
+#include "eval/eval.h"
+#include "eval/eval_cache.h"
+#include "movegen/attack_map.h"
+#include "movegen/attacks.h"
+#include "movegen/movegen.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace aetherchess {
+namespace Microbench {
+
+// Keeps the compiler from discarding a computed value. Objects that do not
+// fit a register are passed by address; an "m" operand on them can make the
+// compiler copy the whole object, which for a Position costs more than the
+// kernels being measured.
+template <typename T>
+inline void do_not_optimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    if constexpr (sizeof(T) <= sizeof(void*)) asm volatile("" : : "r,m"(value) : "memory");
+    else asm volatile("" : : "r"(&value) : "memory");
+#else
+    const volatile char* p = reinterpret_cast<const volatile char*>(&value);
+    (void)*p;
+#endif
+}
+
+static const char* const BENCH_FENS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+    "2r3k1/pp3ppp/2n1b3/3p4/3P4/2PB1N2/P4PPP/4R1K1 b - - 3 22",
+    "8/5pk1/6p1/2R5/5P2/6PK/r7/8 w - - 0 45",
+    "6k1/5ppp/8/8/8/8/5PPP/3Q2K1 w - - 0 1",
+    "r2q1rk1/ppp2ppp/2n1bn2/2bpp3/4P3/2PP1NP1/PP1NQPBP/R1B2RK1 b - - 5 9",
+    "4k3/8/8/3PpP2/8/8/8/4K3 w - e6 0 2",
+};
+
+struct Options {
+    int repeats = 25;
+    int warmup = 5;
+    double min_ms = 5.0;
+    uint64_t seed = 1;
+    std::string filter;
+    std::string format = "text";
+    std::string output;
+    std::string compare;
+    double threshold = 5.0;
+};
+
+// One kernel. run(n) performs n iterations of ops_per_iteration operations and
+// returns a checksum that depends on all of them.
+struct Kernel {
+    std::string name;
+    uint64_t ops_per_iteration;
+    std::function<uint64_t(uint64_t)> run;
+};
+
+struct Result {
+    std::string name;
+    uint64_t ops_per_sample = 0;
+    std::vector<double> ns_per_op; // sorted
+    double min() const { return ns_per_op.front(); }
+    double max() const { return ns_per_op.back(); }
+    double percentile(double p) const {
+        const double rank = p * static_cast<double>(ns_per_op.size() - 1);
+        const size_t lo = static_cast<size_t>(rank);
+        const size_t hi = std::min(lo + 1, ns_per_op.size() - 1);
+        return ns_per_op[lo] + (ns_per_op[hi] - ns_per_op[lo]) * (rank - static_cast<double>(lo));
+    }
+    double median() const { return percentile(0.5); }
+};
+
+// Shared inputs of the kernels.
+struct Inputs {
+    struct SliderQuery {
+        Square square;
+        Bitboard occupied;
+    };
+    std::vector<SliderQuery> slider_queries;
+    std::vector<std::string> fens;
+    std::vector<Position> positions;
+    std::vector<std::vector<Move>> legal_moves;
+    uint64_t total_legal_moves = 0;
+};
+
+static Inputs make_inputs(uint64_t seed) {
+    Inputs in;
+    std::mt19937_64 rng(seed);
+    // Two ANDed random words give a quarter-full board, close to middlegame
+    // occupancy; a third of the queries use sparser endgame-like boards.
+    for (int i = 0; i < 4096; ++i) {
+        Bitboard occupied = rng() & rng();
+        if (i % 3 == 0) occupied &= rng();
+        in.slider_queries.push_back({static_cast<Square>(rng() % 64), occupied});
+    }
+    for (const char* fen : BENCH_FENS) {
+        in.fens.emplace_back(fen);
+        Position pos;
+        pos.set_from_fen(fen);
+        MoveList list;
+        MoveGenerator::generate_moves(pos, list);
+        std::vector<Move> legal;
+        for (int i = 0; i < list.count; ++i) {
+            if (pos.is_legal(list.moves[i])) legal.push_back(list.moves[i]);
+        }
+        in.total_legal_moves += legal.size();
+        in.positions.push_back(pos);
+        in.legal_moves.push_back(std::move(legal));
+    }
+    return in;
+}
+
+// The eval cache kernels probe each position under this many keys: its own
+// key with the slot bits replaced, so that every key gets a cache line of its
+// own and the 3072 keys cover three quarters of a default-size cache.
+static constexpr uint64_t EVAL_CACHE_KEYS_PER_POSITION = 256;
+
+static uint64_t cache_key(const Position& pos, uint64_t index) {
+    return (pos.hash_key & ~0x7FFFULL) | ((index * 8) & 0x7FFF);
+}
+
+static std::vector<Kernel> make_kernels(Inputs& in) {
+    std::vector<Kernel> kernels;
+    const uint64_t queries = in.slider_queries.size();
+    const uint64_t positions = in.positions.size();
+
+    kernels.push_back({"rook_attacks", queries, [&in](uint64_t n) {
+        uint64_t sum = 0;
+        for (uint64_t it = 0; it < n; ++it) {
+            for (const auto& q : in.slider_queries) sum ^= Attacks::get_rook_attacks(q.square, q.occupied);
+        }
+        return sum;
+    }});
+    kernels.push_back({"bishop_attacks", queries, [&in](uint64_t n) {
+        uint64_t sum = 0;
+        for (uint64_t it = 0; it < n; ++it) {
+            for (const auto& q : in.slider_queries) sum ^= Attacks::get_bishop_attacks(q.square, q.occupied);
+        }
+        return sum;
+    }});
+    // Each query's occupancy depends on the previous result, so this measures
+    // the latency of a lookup rather than the throughput of independent ones.
+    kernels.push_back({"queen_latency", queries, [&in](uint64_t n) {
+        uint64_t sum = 0;
+        Bitboard previous = 0;
+        for (uint64_t it = 0; it < n; ++it) {
+            for (const auto& q : in.slider_queries) {
+                previous = Attacks::get_queen_attacks(q.square, q.occupied ^ (previous >> 63));
+                sum ^= previous;
+            }
+        }
+        return sum;
+    }});
+    kernels.push_back({"generate_moves", positions, [&in](uint64_t n) {
+        uint64_t sum = 0;
+        MoveList list;
+        for (uint64_t it = 0; it < n; ++it) {
+            for (const Position& pos : in.positions) {
+                list.count = 0;
+                MoveGenerator::generate_moves(pos, list);
+                do_not_optimize(list);
+                sum += list.count;
+            }
+        }
+        return sum;
+    }});
+    kernels.push_back({"make_unmake", in.total_legal_moves, [&in](uint64_t n) {
+        uint64_t sum = 0;
+        for (uint64_t it = 0; it < n; ++it) {
+            for (size_t p = 0; p < in.positions.size(); ++p) {
+                Position& pos = in.positions[p];
+                for (const Move m : in.legal_moves[p]) {
+                    pos.make_move(m);
+                    sum += pos.hash_key;
+                    pos.unmake_move(m);
+                }
+            }
+        }
+        return sum;
+    }});
+    kernels.push_back({"evaluate", positions, [&in](uint64_t n) {
+        uint64_t sum = 0;
+        for (uint64_t it = 0; it < n; ++it) {
+            for (const Position& pos : in.positions) {
+                do_not_optimize(pos);
+                sum += static_cast<uint64_t>(Eval::evaluate(pos));
+            }
+        }
+        return sum;
+    }});
+    // The evaluation cache as the search uses it, with all hits and with all
+    // misses (probe, evaluate, store). The keys are spread over the whole table,
+    // as search keys are. Together with "evaluate" these give the hit rate
+    // above which the cache pays off, printed below the table.
+    const uint64_t cache_probes = positions * EVAL_CACHE_KEYS_PER_POSITION;
+    Eval::EvalCache warm_cache;
+    uint64_t warm_index = 0;
+    for (const Position& pos : in.positions) {
+        const int score = Eval::evaluate(pos);
+        for (uint64_t j = 0; j < EVAL_CACHE_KEYS_PER_POSITION; ++j) {
+            warm_cache.store(cache_key(pos, warm_index++), score);
+        }
+    }
+    kernels.push_back({"eval_cache_hit", cache_probes, [&in, warm_cache](uint64_t n) {
+        uint64_t sum = 0;
+        for (uint64_t it = 0; it < n; ++it) {
+            uint64_t index = 0;
+            for (const Position& pos : in.positions) {
+                for (uint64_t j = 0; j < EVAL_CACHE_KEYS_PER_POSITION; ++j) {
+                    int score = 0;
+                    if (!warm_cache.probe(cache_key(pos, index++), score)) score = Eval::evaluate(pos);
+                    sum += static_cast<uint64_t>(score);
+                }
+            }
+        }
+        return sum;
+    }});
+    // The salt changes the key tags on every pass, across samples too, so no
+    // probe finds the entry stored by the previous pass.
+    kernels.push_back({"eval_cache_miss", cache_probes, [&in, cache = Eval::EvalCache(), salt = uint64_t(0)](
+                                                            uint64_t n) mutable {
+        uint64_t sum = 0;
+        for (uint64_t it = 0; it < n; ++it) {
+            salt += 1ULL << 32;
+            uint64_t index = 0;
+            for (const Position& pos : in.positions) {
+                for (uint64_t j = 0; j < EVAL_CACHE_KEYS_PER_POSITION; ++j) {
+                    const uint64_t key = cache_key(pos, index++) ^ salt;
+                    int score = 0;
+                    if (!cache.probe(key, score)) {
+                        do_not_optimize(pos);
+                        score = Eval::evaluate(pos);
+                        cache.store(key, score);
+                    }
+                    sum += static_cast<uint64_t>(score);
+                }
+            }
+        }
+        return sum;
+    }});
+    // The dispatched implementation (AVX2 Kogge-Stone where supported) and the
+    // magic-lookup fallback.
+    kernels.push_back({"attack_map", positions, [&in](uint64_t n) {
+        uint64_t sum = 0;
+        Attacks::AttackMap map;
+        for (uint64_t it = 0; it < n; ++it) {
+            for (const Position& pos : in.positions) {
+                do_not_optimize(pos);
+                Attacks::compute_attack_map(pos, map);
+                sum ^= map.by_color[0] ^ map.by_color[1];
+            }
+        }
+        return sum;
+    }});
+    kernels.push_back({"attack_map_magic", positions, [&in](uint64_t n) {
+        uint64_t sum = 0;
+        Attacks::AttackMap map;
+        for (uint64_t it = 0; it < n; ++it) {
+            for (const Position& pos : in.positions) {
+                do_not_optimize(pos);
+                Attacks::compute_attack_map_magic(pos, map);
+                sum ^= map.by_color[0] ^ map.by_color[1];
+            }
+        }
+        return sum;
+    }});
+    kernels.push_back({"calculate_hash", positions, [&in](uint64_t n) {
+        uint64_t sum = 0;
+        for (uint64_t it = 0; it < n; ++it) {
+            for (const Position& pos : in.positions) {
+                do_not_optimize(pos);
+                sum ^= pos.calculate_hash();
+            }
+        }
+        return sum;
+    }});
+    kernels.push_back({"set_from_fen", in.fens.size(), [&in](uint64_t n) {
+        uint64_t sum = 0;
+        auto pos = std::make_unique<Position>();
+        for (uint64_t it = 0; it < n; ++it) {
+            for (const std::string& fen : in.fens) {
+                pos->set_from_fen(fen);
+                sum ^= pos->hash_key;
+            }
+        }
+        return sum;
+    }});
+    return kernels;
+}
+
+static double time_ns(const Kernel& kernel, uint64_t iterations) {
+    const auto start = std::chrono::steady_clock::now();
+    const uint64_t checksum = kernel.run(iterations);
+    const auto end = std::chrono::steady_clock::now();
+    do_not_optimize(checksum);
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+static Result measure(const Kernel& kernel, const Options& options) {
+    // Doubles the iteration count until one sample is long enough for the
+    // clock resolution not to matter.
+    uint64_t iterations = 1;
+    while (time_ns(kernel, iterations) < options.min_ms * 1e6 && iterations < (1ULL << 40)) iterations *= 2;
+
+    for (int i = 0; i < options.warmup; ++i) time_ns(kernel, iterations);
+
+    Result result;
+    result.name = kernel.name;
+    result.ops_per_sample = iterations * kernel.ops_per_iteration;
+    for (int i = 0; i < options.repeats; ++i) {
+        result.ns_per_op.push_back(time_ns(kernel, iterations) / static_cast<double>(result.ops_per_sample));
+    }
+    std::sort(result.ns_per_op.begin(), result.ns_per_op.end());
+    return result;
+}
+
+static void write_text(std::ostream& os, const std::vector<Result>& results) {
+    os << std::left << std::setw(18) << "kernel" << std::right << std::setw(14) << "ops/sample"
+       << std::setw(10) << "min" << std::setw(10) << "p10" << std::setw(10) << "median" << std::setw(10)
+       << "p90" << std::setw(10) << "max" << "  (ns/op)\n";
+    os << std::fixed << std::setprecision(2);
+    for (const Result& r : results) {
+        os << std::left << std::setw(18) << r.name << std::right << std::setw(14) << r.ops_per_sample
+           << std::setw(10) << r.min() << std::setw(10) << r.percentile(0.1) << std::setw(10) << r.median()
+           << std::setw(10) << r.percentile(0.9) << std::setw(10) << r.max() << "\n";
+    }
+    // A cached evaluation costs h * hit + (1 - h) * miss at hit rate h, which
+    // matches a plain one at h = (miss - evaluate) / (miss - hit).
+    const auto median_of = [&results](const std::string& name) {
+        for (const Result& r : results) {
+            if (r.name == name) return r.median();
+        }
+        return -1.0;
+    };
+    const double evaluate = median_of("evaluate"), hit = median_of("eval_cache_hit"),
+                 miss = median_of("eval_cache_miss");
+    if (evaluate >= 0 && hit >= 0 && miss > hit) {
+        os << "eval cache break-even hit rate: " << 100 * std::max(0.0, (miss - evaluate) / (miss - hit))
+           << "%\n";
+    }
+    os << std::defaultfloat;
+}
+
+static void write_csv(std::ostream& os, const std::vector<Result>& results) {
+    os << "kernel,ops_per_sample,samples,min_ns,p10_ns,median_ns,p90_ns,max_ns\n";
+    os << std::fixed << std::setprecision(3);
+    for (const Result& r : results) {
+        os << r.name << "," << r.ops_per_sample << "," << r.ns_per_op.size() << "," << r.min() << ","
+           << r.percentile(0.1) << "," << r.median() << "," << r.percentile(0.9) << "," << r.max() << "\n";
+    }
+    os << std::defaultfloat;
+}
+
+static void write_json(std::ostream& os, const std::vector<Result>& results) {
+    os << "[\n" << std::fixed << std::setprecision(3);
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        os << "  {\"kernel\": \"" << r.name << "\", \"ops_per_sample\": " << r.ops_per_sample
+           << ", \"samples\": " << r.ns_per_op.size() << ", \"min_ns\": " << r.min()
+           << ", \"p10_ns\": " << r.percentile(0.1) << ", \"median_ns\": " << r.median()
+           << ", \"p90_ns\": " << r.percentile(0.9) << ", \"max_ns\": " << r.max() << "}"
+           << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    os << "]\n" << std::defaultfloat;
+}
+
+// Reads kernel medians from a CSV or JSON report written by this program.
+static bool read_baseline(const std::string& path, std::map<std::string, double>& medians) {
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (const size_t k = line.find("\"kernel\": \""); k != std::string::npos) {
+            const size_t begin = k + 11;
+            const size_t end = line.find('"', begin);
+            const size_t m = line.find("\"median_ns\": ");
+            if (end == std::string::npos || m == std::string::npos) continue;
+            medians[line.substr(begin, end - begin)] = std::strtod(line.c_str() + m + 13, nullptr);
+        } else if (!line.empty() && line[0] != '[' && line[0] != ']' && line.rfind("kernel,", 0) != 0) {
+            std::vector<std::string> fields;
+            std::istringstream ls(line);
+            for (std::string field; std::getline(ls, field, ',');) fields.push_back(field);
+            if (fields.size() >= 6) medians[fields[0]] = std::strtod(fields[5].c_str(), nullptr);
+        }
+    }
+    return true;
+}
+
+// Prints the change of every median against the baseline. Returns the number
+// of kernels that got slower by more than the threshold.
+static int compare(const std::vector<Result>& results, const std::map<std::string, double>& baseline,
+                   double threshold) {
+    int regressions = 0;
+    std::cout << "\n" << std::left << std::setw(18) << "kernel" << std::right << std::setw(12) << "baseline"
+              << std::setw(12) << "current" << std::setw(10) << "change" << "\n"
+              << std::fixed << std::setprecision(2);
+    for (const Result& r : results) {
+        const auto it = baseline.find(r.name);
+        if (it == baseline.end() || it->second <= 0) {
+            std::cout << std::left << std::setw(18) << r.name << std::right << std::setw(12) << "-"
+                      << std::setw(12) << r.median() << std::setw(10) << "-" << "\n";
+            continue;
+        }
+        const double change = 100.0 * (r.median() / it->second - 1.0);
+        const bool regressed = change > threshold;
+        regressions += regressed;
+        std::cout << std::left << std::setw(18) << r.name << std::right << std::setw(12) << it->second
+                  << std::setw(12) << r.median() << std::setw(9) << std::showpos << change << std::noshowpos
+                  << "%" << (regressed ? "  REGRESSION" : "") << "\n";
+    }
+    std::cout << std::defaultfloat;
+    if (regressions) std::cout << regressions << " kernel(s) slower than the baseline by more than " << threshold << "%\n";
+    return regressions;
+}
+
+static void usage() {
+    std::cout << "Usage: aetherchess_microbench [--repeats n] [--warmup n] [--min-ms ms] [--seed n]\n"
+                 "                              [--filter substring] [--format text|csv|json] [--output file]\n"
+                 "                              [--compare baseline] [--threshold percent]\n";
+}
+
+static bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) return false;
+        const std::string value = argv[++i];
+        if (arg == "--repeats") options.repeats = std::max(1, std::atoi(value.c_str()));
+        else if (arg == "--warmup") options.warmup = std::max(0, std::atoi(value.c_str()));
+        else if (arg == "--min-ms") options.min_ms = std::max(0.1, std::atof(value.c_str()));
+        else if (arg == "--seed") options.seed = std::strtoull(value.c_str(), nullptr, 10);
+        else if (arg == "--filter") options.filter = value;
+        else if (arg == "--format") options.format = value;
+        else if (arg == "--output") options.output = value;
+        else if (arg == "--compare") options.compare = value;
+        else if (arg == "--threshold") options.threshold = std::atof(value.c_str());
+        else return false;
+    }
+    return options.format == "text" || options.format == "csv" || options.format == "json";
+}
+
+static int run(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+
+    std::map<std::string, double> baseline;
+    if (!options.compare.empty() && !read_baseline(options.compare, baseline)) {
+        std::cerr << "Cannot read baseline " << options.compare << "\n";
+        return 2;
+    }
+
+    Inputs inputs = make_inputs(options.seed);
+    std::vector<Result> results;
+    for (const Kernel& kernel : make_kernels(inputs)) {
+        if (!options.filter.empty() && kernel.name.find(options.filter) == std::string::npos) continue;
+        results.push_back(measure(kernel, options));
+    }
+
+    std::ofstream file;
+    if (!options.output.empty()) {
+        file.open(options.output);
+        if (!file) {
+            std::cerr << "Cannot write " << options.output << "\n";
+            return 2;
+        }
+    }
+    std::ostream& out = options.output.empty() ? std::cout : file;
+    if (options.format == "csv") write_csv(out, results);
+    else if (options.format == "json") write_json(out, results);
+    else write_text(out, results);
+    // The report on stdout stays readable when the machine format goes to a file.
+    if (!options.output.empty() && options.format != "text") write_text(std::cout, results);
+
+    if (!options.compare.empty() && compare(results, baseline, options.threshold) > 0) return 1;
+    return 0;
+}
+
+} // namespace Microbench
+} // namespace aetherchess
+
+int main(int argc, char* argv[]) {
+    aetherchess::init();
+    return aetherchess::Microbench::run(argc, argv);
+}
@@ -0,0 +1,188 @@
+#include "opening_tree.h"
+#include "../io/pgn.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <queue>
+#include <vector>
+
+namespace aetherchess {
+namespace OpeningTree {
+
+static bool entry_less(const Entry& a, const Entry& b) {
+    return a.key != b.key ? a.key < b.key : a.move < b.move;
+}
+
+static bool same_edge(const Entry& a, const Entry& b) {
+    return a.key == b.key && a.move == b.move;
+}
+
+static void accumulate(Entry& into, const Entry& from) {
+    into.games += from.games;
+    into.wins += from.wins;
+    into.draws += from.draws;
+}
+
+namespace {
+
+// Shared state of one build: the run files written so far and the first error.
+struct RunSet {
+    std::string prefix;
+    std::mutex mutex;
+    std::vector<std::string> paths;
+    std::string error;
+
+    // Sorts and aggregates 'buffer' in place and writes it as a new run.
+    void spill(std::vector<Entry>& buffer) {
+        if (buffer.empty()) return;
+        std::sort(buffer.begin(), buffer.end(), entry_less);
+        size_t out = 0;
+        for (size_t i = 1; i < buffer.size(); ++i) {
+            if (same_edge(buffer[out], buffer[i])) accumulate(buffer[out], buffer[i]);
+            else buffer[++out] = buffer[i];
+        }
+        buffer.resize(out + 1);
+
+        std::string path;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            path = prefix + ".run" + std::to_string(paths.size());
+            paths.push_back(path);
+        }
+        DatasetWriter<Entry> writer;
+        bool ok = writer.open(path);
+        if (ok) for (const Entry& e : buffer) writer.write(e);
+        ok = writer.close() && ok;
+        if (!ok) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (error.empty()) error = "cannot write run file " + path;
+        }
+        buffer.clear();
+    }
+};
+
+class TreeVisitor : public PGN::Visitor {
+public:
+    TreeVisitor(RunSet& runs, size_t capacity, int max_plies, std::atomic<uint64_t>& edges)
+        : runs(runs), capacity(capacity), max_plies(max_plies), edges(edges) {
+        buffer.reserve(capacity);
+    }
+
+    ~TreeVisitor() override {
+        runs.spill(buffer);
+        edges += local_edges;
+    }
+
+    void begin_game() override { game.clear(); }
+
+    void move(Position& pos, Move m) override {
+        if (static_cast<int>(game.size()) < max_plies) game.push_back({pos.hash_key, m, pos.side_to_move});
+    }
+
+    void end_game(PGN::GameResult result, bool ok) override {
+        if (!ok || result == PGN::GameResult::UNKNOWN) return;
+        for (const Ply& ply : game) {
+            Entry e{ply.key, ply.move, 0, 1, 0, 0};
+            if (result == PGN::GameResult::DRAW) e.draws = 1;
+            else if ((result == PGN::GameResult::WHITE_WINS) == (ply.mover == Color::WHITE)) e.wins = 1;
+            buffer.push_back(e);
+            if (buffer.size() == capacity) runs.spill(buffer);
+        }
+        local_edges += game.size();
+    }
+
+private:
+    struct Ply {
+        uint64_t key;
+        Move move;
+        Color mover;
+    };
+
+    RunSet& runs;
+    size_t capacity;
+    int max_plies;
+    std::atomic<uint64_t>& edges;
+    uint64_t local_edges = 0;
+    std::vector<Ply> game;
+    std::vector<Entry> buffer;
+};
+
+} // namespace
+
+// K-way merge of the sorted runs into the index, summing equal edges.
+static bool merge_runs(const std::vector<std::string>& paths, const BuildOptions& options, BuildStats& stats,
+                       std::string& error) {
+    std::vector<DatasetReader<Entry>> readers(paths.size());
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (!readers[i].open(paths[i], error)) return false;
+    }
+
+    using Cursor = std::pair<Entry, size_t>; // Current entry and the run it came from
+    auto greater = [](const Cursor& a, const Cursor& b) { return entry_less(b.first, a.first); };
+    std::priority_queue<Cursor, std::vector<Cursor>, decltype(greater)> heap(greater);
+    std::vector<size_t> next(paths.size(), 0);
+    for (size_t i = 0; i < readers.size(); ++i) {
+        if (readers[i].size()) heap.push({readers[i][next[i]++], i});
+    }
+
+    DatasetWriter<Entry> writer;
+    if (!writer.open(options.output_path)) {
+        error = "cannot create " + options.output_path;
+        return false;
+    }
+    while (!heap.empty()) {
+        Entry merged{heap.top().first.key, heap.top().first.move, 0, 0, 0, 0};
+        while (!heap.empty() && same_edge(heap.top().first, merged)) {
+            const auto [entry, run] = heap.top();
+            heap.pop();
+            accumulate(merged, entry);
+            if (next[run] < readers[run].size()) heap.push({readers[run][next[run]++], run});
+        }
+        if (merged.games >= options.min_games) writer.write(merged);
+    }
+    stats.entries = writer.size();
+    if (!writer.close()) {
+        error = "write error on " + options.output_path;
+        return false;
+    }
+    return true;
+}
+
+bool build(const BuildOptions& options, BuildStats& stats, std::string& error) {
+    const int threads = std::max(1, options.threads);
+    const size_t capacity = std::max<size_t>(options.memory_mb * (1 << 20) / sizeof(Entry) / threads, 1024);
+
+    RunSet runs;
+    runs.prefix = options.output_path;
+    std::atomic<uint64_t> edges{0};
+    PGN::Stats pgn_stats;
+    const bool opened = PGN::replay_file(options.pgn_path, threads, [&](int) {
+        return std::make_unique<TreeVisitor>(runs, capacity, options.max_plies, edges);
+    }, pgn_stats);
+
+    stats = {};
+    stats.games = pgn_stats.games;
+    stats.edges = edges;
+    stats.runs = runs.paths.size();
+
+    bool ok = opened;
+    if (!opened) error = "cannot open " + options.pgn_path;
+    else if (!runs.error.empty()) { error = runs.error; ok = false; }
+    else ok = merge_runs(runs.paths, options, stats, error);
+
+    for (const std::string& path : runs.paths) std::remove(path.c_str());
+    return ok;
+}
+
+std::span<const Entry> Index::lookup(uint64_t key) const {
+    const std::span<const Entry> all = reader.records();
+    const auto first = std::lower_bound(all.begin(), all.end(), key,
+                                        [](const Entry& e, uint64_t k) { return e.key < k; });
+    auto last = first;
+    while (last != all.end() && last->key == key) ++last;
+    return all.subspan(static_cast<size_t>(first - all.begin()), static_cast<size_t>(last - first));
+}
+
+} // namespace OpeningTree
+} // namespace aetherchess
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "../core/types.h"
+#include "../io/dataset.h"
+#include <cstdint>
+#include <span>
+#include <string>
+
+namespace aetherchess {
+namespace OpeningTree {
+
+// One (position, move) edge of the tree with the results of the games that
+// played it, from the point of view of the side making the move. Keys are the
+// engine's Zobrist keys. The index file is a dataset of these records sorted
+// by (key, move).
+struct Entry {
+    static constexpr uint32_t RECORD_TYPE = 2;
+
+    uint64_t key;
+    Move move;
+    uint16_t reserved;
+    uint32_t games;
+    uint32_t wins;
+    uint32_t draws;
+
+    uint32_t losses() const { return games - wins - draws; }
+    // Expected score for the mover, in [0, 1].
+    double score() const { return games ? (wins + 0.5 * draws) / games : 0.0; }
+};
+
+static_assert(sizeof(Entry) == 24, "Entry must stay 24 bytes");
+
+struct BuildOptions {
+    std::string pgn_path;
+    std::string output_path;
+    int threads = 1;
+    int max_plies = 30;       // Only the first plies of each game enter the tree
+    size_t memory_mb = 256;   // Budget for the in-memory sort buffers of all threads
+    uint32_t min_games = 1;   // Edges played fewer times are dropped
+};
+
+struct BuildStats {
+    uint64_t games = 0;
+    uint64_t edges = 0;       // (position, move) occurrences replayed
+    uint64_t runs = 0;        // Sorted runs spilled to disk
+    uint64_t entries = 0;     // Distinct edges written to the index
+};
+
+// Replays the games of a PGN file and writes the sorted index. Each thread
+// aggregates edges in a bounded buffer and spills it as a sorted run; the runs
+// are then merged into the index, so memory stays within the budget however
+// large the input is. Returns false and sets 'error' on failure.
+bool build(const BuildOptions& options, BuildStats& stats, std::string& error);
+
+// A memory-mapped tree index.
+class Index {
+public:
+    bool open(const std::string& path, std::string& error) { return reader.open(path, error, false); }
+    size_t size() const { return reader.size(); }
+
+    // Returns the edges leaving the position with the given key, ordered by move.
+    std::span<const Entry> lookup(uint64_t key) const;
+
+private:
+    DatasetReader<Entry> reader;
+};
+
+} // namespace OpeningTree
+} // namespace aetherchess
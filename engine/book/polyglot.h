@@ -0,0 +1,55 @@
+#pragma once
+
+#include "../core/position.h"
+#include "../io/mapped_file.h"
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <string>
+
+namespace aetherchess {
+namespace Polyglot {
+
+// Computes the Polyglot hash of pos. This is independent of the engine's own
+// Zobrist keys, so that books written by other programs can be probed.
+uint64_t key(const Position& pos);
+
+// A candidate book move for the probed position.
+struct BookMove {
+    Move move;
+    uint16_t weight;
+};
+
+// Upper bound on the candidates returned by a single probe.
+constexpr int MAX_BOOK_MOVES = 64;
+
+// A memory-mapped Polyglot opening book: a sorted array of 16-byte big-endian
+// entries (key, move, weight, learn). Probing is a binary search over the
+// mapping and never allocates.
+class Book {
+public:
+    // Maps the book at path. Returns false if it cannot be opened or its size
+    // is not a whole number of entries.
+    bool open(const std::string& path);
+    void close();
+
+    bool is_open() const { return file.is_open(); }
+    size_t size() const { return file.size() / ENTRY_SIZE; }
+
+    // Stores the legal book moves for pos in 'out', best weight first, and
+    // returns how many there are. Entries that match no legal move are skipped.
+    int probe(const Position& pos, std::span<BookMove> out) const;
+
+    // Picks one of the book moves for pos at random, proportionally to the
+    // weights. Returns MOVE_NONE if the position is not in the book.
+    Move pick(const Position& pos, std::mt19937_64& rng) const;
+
+private:
+    static constexpr size_t ENTRY_SIZE = 16;
+
+    MappedFile file;
+};
+
+} // namespace Polyglot
+} // namespace aetherchess
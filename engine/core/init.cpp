@@ -0,0 +1,17 @@
+#include "init.h"
+#include "../movegen/attacks.h"
+#include "../zobrist/zobrist.h"
+#include <mutex>
+
+namespace aetherchess {
+
+void init() {
+    static std::once_flag once;
+    std::call_once(once, [] {
+        Zobrist::init();
+        Attacks::init();
+        Zobrist::init_cuckoo();
+    });
+}
+
+} // namespace aetherchess
@@ -0,0 +1,12 @@
+#pragma once
+
+namespace aetherchess {
+
+// Builds the global tables: the Zobrist keys, the attack tables and the
+// cuckoo tables of reversible moves. The first call does the work and every
+// later or concurrent call waits for it, so any entry point (main, the
+// library, the benchmarks) may call it; the tables are read-only afterwards
+// and shared by all engines in the process.
+void init();
+
+} // namespace aetherchess
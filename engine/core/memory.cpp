@@ -0,0 +1,186 @@
+#include "memory.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace aetherchess {
+
+namespace {
+
+// Maps 'bytes' (a multiple of HUGE_PAGE_SIZE) of anonymous memory at a 2 MB
+// boundary by over-allocating one huge page and trimming both ends.
+void* map_aligned(size_t bytes) {
+    const size_t total = bytes + HUGE_PAGE_SIZE;
+    void* base = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) return nullptr;
+
+    const uintptr_t start = reinterpret_cast<uintptr_t>(base);
+    const uintptr_t aligned = (start + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+    if (aligned > start) munmap(base, aligned - start);
+    const size_t tail = start + total - (aligned + bytes);
+    if (tail) munmap(reinterpret_cast<void*>(aligned + bytes), tail);
+    return reinterpret_cast<void*>(aligned);
+}
+
+std::string format_size(size_t bytes) {
+    std::ostringstream os;
+    if (bytes >= 1024 * 1024) os << bytes / (1024 * 1024) << " MB";
+    else os << (bytes + 1023) / 1024 << " KB";
+    return os.str();
+}
+
+} // namespace
+
+LargePageBuffer::LargePageBuffer(LargePageBuffer&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0)),
+      mapped_size_(std::exchange(other.mapped_size_, 0)),
+      mode_(std::exchange(other.mode_, PageMode::NONE)) {}
+
+LargePageBuffer& LargePageBuffer::operator=(LargePageBuffer&& other) noexcept {
+    if (this != &other) {
+        release();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        mapped_size_ = std::exchange(other.mapped_size_, 0);
+        mode_ = std::exchange(other.mode_, PageMode::NONE);
+    }
+    return *this;
+}
+
+bool LargePageBuffer::allocate(size_t bytes) {
+    release();
+    if (bytes == 0) return true;
+    const size_t rounded = (bytes + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+
+#ifdef MAP_HUGETLB
+    void* p = mmap(nullptr, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED) {
+        data_ = p;
+        mode_ = PageMode::EXPLICIT;
+    }
+#endif
+    if (!data_ && (data_ = map_aligned(rounded))) {
+#ifdef MADV_HUGEPAGE
+        madvise(data_, rounded, MADV_HUGEPAGE);
+#endif
+        mode_ = PageMode::TRANSPARENT;
+    }
+    if (!data_ && (data_ = std::aligned_alloc(HUGE_PAGE_SIZE, rounded))) mode_ = PageMode::HEAP;
+    if (!data_) return false;
+
+    size_ = bytes;
+    mapped_size_ = rounded;
+    // Mappings are already zero, but writing them faults every page in now.
+    clear();
+    return true;
+}
+
+bool LargePageBuffer::map_file(const std::string& path, size_t offset) {
+    release();
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    void* p = MAP_FAILED;
+    size_t bytes = 0;
+    if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) > offset) {
+        bytes = static_cast<size_t>(st.st_size) - offset;
+        p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, static_cast<off_t>(offset));
+    }
+    ::close(fd); // The mapping keeps the file open.
+    if (p == MAP_FAILED) return false;
+
+    // Start reading the file in the background; probes that get ahead of it
+    // wait for their page only.
+    madvise(p, bytes, MADV_WILLNEED);
+    data_ = p;
+    size_ = mapped_size_ = bytes;
+    mode_ = PageMode::FILE;
+    return true;
+}
+
+void LargePageBuffer::release() {
+    if (!data_) return;
+    if (mode_ == PageMode::HEAP) std::free(data_);
+    else munmap(data_, mapped_size_);
+    data_ = nullptr;
+    size_ = mapped_size_ = 0;
+    mode_ = PageMode::NONE;
+}
+
+void LargePageBuffer::clear() {
+    Memory::parallel_clear(data_, mapped_size_);
+}
+
+size_t LargePageBuffer::huge_page_bytes() const {
+    if (mode_ == PageMode::EXPLICIT) return mapped_size_;
+    if (!data_) return 0;
+
+    // Sum AnonHugePages over the mappings that overlap the block. A mapping
+    // may extend beyond it when the kernel merged neighbours, so each is
+    // capped at the overlap.
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(data_), end = begin + mapped_size_;
+    std::ifstream smaps("/proc/self/smaps");
+    std::string line;
+    size_t total = 0, overlap = 0;
+    while (std::getline(smaps, line)) {
+        // A mapping starts with its lower-case hex address range; the fields
+        // that follow start with a capitalized name.
+        if (!line.empty() && (std::isdigit(line[0]) || (line[0] >= 'a' && line[0] <= 'f'))) {
+            uintptr_t lo = 0, hi = 0;
+            char dash;
+            std::istringstream(line) >> std::hex >> lo >> dash >> hi;
+            overlap = lo < end && hi > begin ? std::min(hi, end) - std::max(lo, begin) : 0;
+        } else if (overlap && line.rfind("AnonHugePages:", 0) == 0) {
+            size_t kb = 0;
+            std::istringstream(line.substr(14)) >> kb;
+            total += std::min(kb * 1024, overlap);
+        }
+    }
+    return std::min(total, mapped_size_);
+}
+
+std::string LargePageBuffer::describe() const {
+    const size_t huge = huge_page_bytes();
+    std::string s = format_size(size_) + ", ";
+    if (mode_ == PageMode::FILE) return s + "mapped from a file";
+    if (huge == 0) return s + "no huge pages";
+    return s + (huge >= size_ ? "all" : format_size(huge)) +
+           (mode_ == PageMode::EXPLICIT ? " in explicit" : " in transparent") + " huge pages";
+}
+
+namespace Memory {
+
+void parallel_clear(void* p, size_t bytes, int threads) {
+    if (!p || bytes == 0) return;
+    if (threads <= 0) {
+        const size_t per_16mb = std::max<size_t>(1, bytes / (16 * 1024 * 1024));
+        const size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+        threads = static_cast<int>(std::min(per_16mb, hardware));
+    }
+    char* const base = static_cast<char*>(p);
+    if (threads == 1) {
+        std::memset(base, 0, bytes);
+        return;
+    }
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t) {
+        const size_t begin = bytes * t / threads, end = bytes * (t + 1) / threads;
+        pool.emplace_back([=]() { std::memset(base + begin, 0, end - begin); });
+    }
+    for (std::thread& th : pool) th.join();
+}
+
+} // namespace Memory
+} // namespace aetherchess
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace aetherchess {
+
+// Size of a huge page on x86-64 and AArch64 Linux.
+constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+// How the memory of a LargePageBuffer was obtained.
+enum class PageMode {
+    NONE,        // Not allocated.
+    EXPLICIT,    // mmap(MAP_HUGETLB) from the reserved huge page pool.
+    TRANSPARENT, // Anonymous mmap, 2 MB aligned, with madvise(MADV_HUGEPAGE).
+    HEAP,        // Aligned heap allocation; mmap failed.
+    FILE         // Private copy-on-write mapping of a file, from map_file().
+};
+
+// A zero-initialized, 2 MB-aligned block for large engine tables, backed by
+// huge pages where the OS provides them so that random access into it does
+// not thrash the TLB. Explicit huge pages are tried first; they only exist if
+// the administrator reserved some (vm.nr_hugepages). Otherwise the block is
+// an ordinary anonymous mapping the kernel may back with transparent huge
+// pages as it is touched.
+class LargePageBuffer {
+public:
+    LargePageBuffer() = default;
+    ~LargePageBuffer() { release(); }
+
+    LargePageBuffer(const LargePageBuffer&) = delete;
+    LargePageBuffer& operator=(const LargePageBuffer&) = delete;
+    LargePageBuffer(LargePageBuffer&& other) noexcept;
+    LargePageBuffer& operator=(LargePageBuffer&& other) noexcept;
+
+    // Replaces the contents with 'bytes' zeroed bytes. The pages are touched
+    // on several threads, so the cost of faulting in a large table is paid up
+    // front and in parallel rather than during the first search. Returns false
+    // if no memory could be obtained at all.
+    bool allocate(size_t bytes);
+
+    // Replaces the contents with the file at 'path' from 'offset' (a multiple
+    // of the page size) to its end. Nothing is read up front: pages come in
+    // from the page cache on first access, and writes stay private to this
+    // process. Returns false if the file cannot be opened or mapped, or has
+    // nothing after 'offset'.
+    bool map_file(const std::string& path, size_t offset);
+
+    void release();
+
+    // Zeroes the whole block, on several threads if it is large.
+    void clear();
+
+    void* data() const { return data_; }
+    size_t size() const { return size_; }
+    PageMode mode() const { return mode_; }
+
+    // Bytes of the block currently backed by huge pages, as reported by the
+    // kernel.
+    size_t huge_page_bytes() const;
+
+    // A one-line summary such as "256 MB, 256 MB in transparent huge pages".
+    std::string describe() const;
+
+private:
+    void* data_ = nullptr;
+    size_t size_ = 0;
+    size_t mapped_size_ = 0; // Size rounded up to whole huge pages.
+    PageMode mode_ = PageMode::NONE;
+};
+
+namespace Memory {
+
+// Zeroes [p, p + bytes) on up to 'threads' threads; 0 picks one thread per
+// 16 MB, capped by the hardware concurrency.
+void parallel_clear(void* p, size_t bytes, int threads = 0);
+
+} // namespace Memory
+} // namespace aetherchess
@@ -1,63 +1,232 @@
 #include "position.h"
+#include "stats.h"
 #include "../movegen/attacks.h"
-#include <vector>
-#include <string>
-#include <sstream>
+#include "../movegen/movegen.h"
+#include "../search/tt.h"
+#include <algorithm>
 
 namespace aetherchess {
 
 // Forward declaration for helper
 static void set_piece(Position& pos, Square s, PieceType pt, Color c, bool is_add);
 
+// Castling rights that survive a move from or to each square. Moving the king
+// or a rook, or capturing on a rook's home square, drops the matching rights.
+static constexpr std::array<uint8_t, 64> castling_mask = [] {
+    std::array<uint8_t, 64> mask{};
+    mask.fill(ANY_CASTLING);
+    mask[E1] = ANY_CASTLING & ~(WHITE_KINGSIDE | WHITE_QUEENSIDE);
+    mask[H1] = ANY_CASTLING & ~WHITE_KINGSIDE;
+    mask[A1] = ANY_CASTLING & ~WHITE_QUEENSIDE;
+    mask[E8] = ANY_CASTLING & ~(BLACK_KINGSIDE | BLACK_QUEENSIDE);
+    mask[H8] = ANY_CASTLING & ~BLACK_KINGSIDE;
+    mask[A8] = ANY_CASTLING & ~BLACK_QUEENSIDE;
+    return mask;
+}();
+
 // --- Public Member Functions ---
 
-void Position::set_from_fen(const std::string& fen_string) {
-    for(int i=0; i<2; ++i) for(int j=0; j<6; ++j) piece_bbs[i][j] = 0;
-    for(int i=0; i<2; ++i) color_bbs[i] = 0;
-    for(int i=0; i<64; ++i) { piece_on_sq[i] = PieceType::NONE; color_on_sq[i] = Color::NONE; }
+FenResult Position::set_from_fen(std::string_view fen) {
+    for (auto& bbs : piece_bbs) for (Bitboard& bb : bbs) bb = 0ULL;
+    for (Bitboard& bb : color_bbs) bb = 0ULL;
+    for (int i = 0; i < 64; ++i) { piece_on_sq[i] = PieceType::NONE; color_on_sq[i] = Color::NONE; }
+    history_ply = 0;
 
-    std::istringstream ss(fen_string);
-    std::string board, side, castling, enpassant, half, full;
-    ss >> board >> side >> castling >> enpassant >> half >> full;
+    size_t i = 0;
+    const size_t n = fen.size();
+    auto fail = [&i](FenError e) { return FenResult{e, i}; };
+    auto skip_spaces = [&]() { while (i < n && (fen[i] == ' ' || fen[i] == '\t')) ++i; };
+    // Fields must be followed by whitespace or the end of the record.
+    auto at_field_end = [&]() { return i == n || fen[i] == ' ' || fen[i] == '\t' || fen[i] == '\n' || fen[i] == '\r'; };
 
+    // 1. Piece placement, from rank 8 down to rank 1.
+    skip_spaces();
     int rank = 7, file = 0;
-    for (char symbol : board) {
-        if (symbol == '/') { rank--; file = 0; }
-        else if (isdigit(symbol)) { file += symbol - '0'; }
-        else {
-            Color c = isupper(symbol) ? Color::WHITE : Color::BLACK;
+    for (; i < n && !at_field_end(); ++i) {
+        const char symbol = fen[i];
+        if (symbol == '/') {
+            if (file != 8) return fail(FenError::BAD_RANK_LENGTH);
+            if (--rank < 0) return fail(FenError::BAD_RANK_COUNT);
+            file = 0;
+        } else if (symbol >= '1' && symbol <= '8') {
+            file += symbol - '0';
+            if (file > 8) return fail(FenError::BAD_RANK_LENGTH);
+        } else {
             PieceType pt;
-            switch (tolower(symbol)) {
+            switch (symbol | 0x20) { // ASCII lower case
                 case 'p': pt = PieceType::PAWN; break; case 'n': pt = PieceType::KNIGHT; break;
                 case 'b': pt = PieceType::BISHOP; break; case 'r': pt = PieceType::ROOK; break;
                 case 'q': pt = PieceType::QUEEN; break; case 'k': pt = PieceType::KING; break;
-                default: continue;
+                default: return fail(FenError::BAD_PIECE);
             }
+            if (file > 7) return fail(FenError::BAD_RANK_LENGTH);
+            if (pt == PieceType::PAWN && (rank == 0 || rank == 7)) return fail(FenError::PAWN_ON_BACK_RANK);
+            const Color c = (symbol >= 'a') ? Color::BLACK : Color::WHITE;
             set_piece(*this, static_cast<Square>(rank * 8 + file), pt, c, true);
             file++;
         }
     }
-    side_to_move = (side == "w") ? Color::WHITE : Color::BLACK;
+    if (rank != 0) return fail(FenError::BAD_RANK_COUNT);
+    if (file != 8) return fail(FenError::BAD_RANK_LENGTH);
+    for (const auto& bbs : piece_bbs) {
+        if (BB::count_bits(bbs[static_cast<int>(PieceType::KING)]) != 1) return fail(FenError::BAD_KING_COUNT);
+    }
+
+    // 2. Side to move.
+    skip_spaces();
+    if (i == n || (fen[i] != 'w' && fen[i] != 'b')) return fail(FenError::BAD_SIDE_TO_MOVE);
+    side_to_move = (fen[i++] == 'w') ? Color::WHITE : Color::BLACK;
+    if (!at_field_end()) return fail(FenError::BAD_SIDE_TO_MOVE);
+
+    // 3. Castling rights. Each right needs the king and rook on their home squares.
+    skip_spaces();
     castling_rights = NO_CASTLING;
-    for(char c : castling) {
-        if (c == 'K') castling_rights = static_cast<CastlingRights>(castling_rights | WHITE_KINGSIDE);
-        if (c == 'Q') castling_rights = static_cast<CastlingRights>(castling_rights | WHITE_QUEENSIDE);
-        if (c == 'k') castling_rights = static_cast<CastlingRights>(castling_rights | BLACK_KINGSIDE);
-        if (c == 'q') castling_rights = static_cast<CastlingRights>(castling_rights | BLACK_QUEENSIDE);
-    }
-    if (enpassant != "-") {
-        int ep_file = enpassant[0] - 'a';
-        int ep_rank = enpassant[1] - '1';
-        en_passant_sq = static_cast<Square>(ep_rank * 8 + ep_file);
+    if (i < n && fen[i] == '-') {
+        ++i;
+    } else {
+        for (; i < n && !at_field_end(); ++i) {
+            Square king_sq, rook_sq;
+            CastlingRights right;
+            switch (fen[i]) {
+                case 'K': right = WHITE_KINGSIDE;  king_sq = E1; rook_sq = H1; break;
+                case 'Q': right = WHITE_QUEENSIDE; king_sq = E1; rook_sq = A1; break;
+                case 'k': right = BLACK_KINGSIDE;  king_sq = E8; rook_sq = H8; break;
+                case 'q': right = BLACK_QUEENSIDE; king_sq = E8; rook_sq = A8; break;
+                default: return fail(FenError::BAD_CASTLING);
+            }
+            const Color c = (right & (WHITE_KINGSIDE | WHITE_QUEENSIDE)) ? Color::WHITE : Color::BLACK;
+            if (piece_on_sq[king_sq] != PieceType::KING || color_on_sq[king_sq] != c ||
+                piece_on_sq[rook_sq] != PieceType::ROOK || color_on_sq[rook_sq] != c) {
+                return fail(FenError::BAD_CASTLING);
+            }
+            castling_rights = static_cast<CastlingRights>(castling_rights | right);
+        }
+    }
+    if (!at_field_end()) return fail(FenError::BAD_CASTLING);
+
+    // 4. En passant target. The pawn that just double-pushed must be in front of it.
+    skip_spaces();
+    en_passant_sq = SQ_NONE;
+    if (i < n && fen[i] == '-') {
+        ++i;
     } else {
-        en_passant_sq = SQ_NONE;
+        if (i + 1 >= n || fen[i] < 'a' || fen[i] > 'h') return fail(FenError::BAD_EN_PASSANT);
+        const int ep_file = fen[i] - 'a';
+        const int ep_rank = fen[i + 1] - '1';
+        const bool white = side_to_move == Color::WHITE;
+        if (ep_rank != (white ? RANK_6 : RANK_3)) return fail(FenError::BAD_EN_PASSANT);
+        const Square ep = static_cast<Square>(ep_rank * 8 + ep_file);
+        const Square pawn_sq = static_cast<Square>(white ? ep - 8 : ep + 8);
+        const Square origin_sq = static_cast<Square>(white ? ep + 8 : ep - 8);
+        if (color_on_sq[ep] != Color::NONE || color_on_sq[origin_sq] != Color::NONE ||
+            piece_on_sq[pawn_sq] != PieceType::PAWN || color_on_sq[pawn_sq] == side_to_move) {
+            return fail(FenError::BAD_EN_PASSANT);
+        }
+        en_passant_sq = ep;
+        i += 2;
     }
-    halfmove_clock = std::stoi(half);
-    fullmove_number = std::stoi(full);
+    if (!at_field_end()) return fail(FenError::BAD_EN_PASSANT);
+
+    // 5-6. Optional move counters. EPD records stop after the en passant field
+    // and continue with operations, which are left for the caller.
+    auto parse_counter = [&](int& value, int min_value) {
+        size_t j = i;
+        while (j < n && (fen[j] == ' ' || fen[j] == '\t')) ++j;
+        if (j == n || fen[j] < '0' || fen[j] > '9') return true; // Absent
+        int v = 0;
+        for (; j < n && fen[j] >= '0' && fen[j] <= '9'; ++j) {
+            v = v * 10 + (fen[j] - '0');
+            if (v > 100000) return false;
+        }
+        const size_t saved = i;
+        i = j;
+        if (!at_field_end() || v < min_value) { i = saved; return false; }
+        value = v;
+        return true;
+    };
+    halfmove_clock = 0;
+    fullmove_number = 1;
+    if (!parse_counter(halfmove_clock, 0)) return fail(FenError::BAD_HALFMOVE_CLOCK);
+    if (!parse_counter(fullmove_number, 1)) return fail(FenError::BAD_FULLMOVE_NUMBER);
+
+    // The side that just moved cannot have left its king in check.
+    const Color them = (side_to_move == Color::WHITE) ? Color::BLACK : Color::WHITE;
+    if (is_in_check(them)) return fail(FenError::OPPONENT_IN_CHECK);
+
     hash_key = calculate_hash();
+    set_check_info();
+    return FenResult{FenError::NONE, i};
+}
+
+std::string Position::to_fen() const {
+    static constexpr char piece_chars[2][6] = {{'P', 'N', 'B', 'R', 'Q', 'K'}, {'p', 'n', 'b', 'r', 'q', 'k'}};
+    std::string fen;
+    fen.reserve(90);
+
+    for (int rank = 7; rank >= 0; --rank) {
+        int empty = 0;
+        for (int file = 0; file < 8; ++file) {
+            const int s = rank * 8 + file;
+            if (color_on_sq[s] == Color::NONE) {
+                ++empty;
+                continue;
+            }
+            if (empty) fen += static_cast<char>('0' + empty);
+            empty = 0;
+            fen += piece_chars[static_cast<int>(color_on_sq[s])][static_cast<int>(piece_on_sq[s])];
+        }
+        if (empty) fen += static_cast<char>('0' + empty);
+        if (rank) fen += '/';
+    }
+
+    fen += side_to_move == Color::WHITE ? " w " : " b ";
+    if (castling_rights & WHITE_KINGSIDE) fen += 'K';
+    if (castling_rights & WHITE_QUEENSIDE) fen += 'Q';
+    if (castling_rights & BLACK_KINGSIDE) fen += 'k';
+    if (castling_rights & BLACK_QUEENSIDE) fen += 'q';
+    if (!castling_rights) fen += '-';
+
+    fen += ' ';
+    if (en_passant_sq == SQ_NONE) {
+        fen += '-';
+    } else {
+        fen += static_cast<char>('a' + en_passant_sq % 8);
+        fen += static_cast<char>('1' + en_passant_sq / 8);
+    }
+    fen += ' ' + std::to_string(halfmove_clock) + ' ' + std::to_string(fullmove_number);
+    return fen;
+}
+
+const char* fen_error_string(FenError e) {
+    switch (e) {
+        case FenError::NONE:                return "ok";
+        case FenError::BAD_PIECE:           return "invalid piece character";
+        case FenError::BAD_RANK_LENGTH:     return "rank does not have 8 files";
+        case FenError::BAD_RANK_COUNT:      return "board does not have 8 ranks";
+        case FenError::PAWN_ON_BACK_RANK:   return "pawn on first or last rank";
+        case FenError::BAD_KING_COUNT:      return "each side needs exactly one king";
+        case FenError::BAD_SIDE_TO_MOVE:    return "side to move must be 'w' or 'b'";
+        case FenError::BAD_CASTLING:        return "invalid castling rights";
+        case FenError::BAD_EN_PASSANT:      return "invalid en passant square";
+        case FenError::BAD_HALFMOVE_CLOCK:  return "invalid halfmove clock";
+        case FenError::BAD_FULLMOVE_NUMBER: return "invalid fullmove number";
+        case FenError::OPPONENT_IN_CHECK:   return "side not to move is in check";
+    }
+    return "unknown error";
 }
 
 bool Position::make_move(Move m) {
+    // Legality is decided up front from the cached check info, so an illegal
+    // move never touches the board.
+    if (!is_legal(m)) {
+        STATS_INC(ILLEGAL_MOVES);
+        return false;
+    }
+    STATS_INC(MAKE_MOVES);
+
+    const uint64_t new_key = key_after(m);
+    if (tt) tt->prefetch(new_key);
+
     history[history_ply].castling_rights = castling_rights;
     history[history_ply].en_passant_sq = en_passant_sq;
     history[history_ply].halfmove_clock = halfmove_clock;
@@ -106,21 +275,14 @@ bool Position::make_move(Move m) {
         set_piece(*this, to, promo_piece, us, true);
     }
 
-    if (castling_rights) {
-        if (moved_piece == PieceType::KING) {
-            if (us == Color::WHITE) castling_rights = static_cast<CastlingRights>(castling_rights & ~(WHITE_KINGSIDE | WHITE_QUEENSIDE));
-            else castling_rights = static_cast<CastlingRights>(castling_rights & ~(BLACK_KINGSIDE | BLACK_QUEENSIDE));
-        }
-        if (from == H1 || to == H1) castling_rights = static_cast<CastlingRights>(castling_rights & ~WHITE_KINGSIDE);
-        if (from == A1 || to == A1) castling_rights = static_cast<CastlingRights>(castling_rights & ~WHITE_QUEENSIDE);
-        if (from == H8 || to == H8) castling_rights = static_cast<CastlingRights>(castling_rights & ~BLACK_KINGSIDE);
-        if (from == A8 || to == A8) castling_rights = static_cast<CastlingRights>(castling_rights & ~BLACK_QUEENSIDE);
-    }
-    if (is_in_check(us)) { unmake_move(m); return false; }
+    castling_rights = static_cast<CastlingRights>(castling_rights & castling_mask[from] & castling_mask[to]);
+    hash_key = new_key;
+    set_check_info();
     return true;
 }
 
 void Position::unmake_move(Move m) {
+    STATS_INC(UNMAKE_MOVES);
     history_ply--;
     const Square from = Moves::get_from(m);
     const Square to = Moves::get_to(m);
@@ -131,6 +293,7 @@ void Position::unmake_move(Move m) {
     castling_rights = history[history_ply].castling_rights;
     en_passant_sq = history[history_ply].en_passant_sq;
     halfmove_clock = history[history_ply].halfmove_clock;
+    hash_key = history[history_ply].hash_key;
     side_to_move = us;
 
     PieceType moved_piece = piece_on_sq[to];
@@ -181,6 +344,345 @@ bool Position::is_square_attacked(Square s, Color attacker_color) const {
     return false;
 }
 
+bool Position::is_pseudo_legal(Move m) const {
+    const Square from = Moves::get_from(m);
+    const Square to = Moves::get_to(m);
+    const MoveType type = Moves::get_type(m);
+    const int us = static_cast<int>(side_to_move);
+    const int them = 1 - us;
+    const Bitboard to_bb = 1ULL << to;
+    const Bitboard occupied = color_bbs[0] | color_bbs[1];
+
+    if (from == to || color_on_sq[from] != side_to_move) return false;
+    // Only the reserved flag values 0b0110 and 0b0111 are never generated.
+    if (type == 0b0110 || type == 0b0111) return false;
+
+    const PieceType pt = piece_on_sq[from];
+    const bool is_capture = type == CAPTURE || type >= PROMO_CAPTURE_KNIGHT;
+
+    if (type == KING_CASTLE || type == QUEEN_CASTLE) {
+        const bool white = side_to_move == Color::WHITE;
+        const Square king_from = white ? E1 : E8;
+        const bool kingside = type == KING_CASTLE;
+        const CastlingRights right = white ? (kingside ? WHITE_KINGSIDE : WHITE_QUEENSIDE)
+                                           : (kingside ? BLACK_KINGSIDE : BLACK_QUEENSIDE);
+        const Square king_to = static_cast<Square>(kingside ? king_from + 2 : king_from - 2);
+        const Square rook_from = static_cast<Square>(kingside ? king_from + 3 : king_from - 4);
+        const Square pass_sq = static_cast<Square>(kingside ? king_from + 1 : king_from - 1);
+
+        return pt == PieceType::KING && from == king_from && to == king_to &&
+               (castling_rights & right) && !(occupied & (Attacks::between_bb[king_from][rook_from] ^ (1ULL << rook_from))) &&
+               !checkers() && !is_square_attacked(pass_sq, static_cast<Color>(them));
+    }
+
+    // Captures need an enemy piece on the target; everything else an empty square.
+    if (is_capture ? !(color_bbs[them] & to_bb) : (occupied & to_bb) != 0) return false;
+
+    if (pt != PieceType::PAWN) {
+        if (type != QUIET && type != CAPTURE) return false;
+        return Attacks::get_piece_attacks(pt, from, occupied) & to_bb;
+    }
+
+    const int push = (side_to_move == Color::WHITE) ? 8 : -8;
+    const Bitboard promo_rank = (side_to_move == Color::WHITE) ? Bitboards::RANK_8 : Bitboards::RANK_1;
+    const Bitboard double_rank = (side_to_move == Color::WHITE) ? Bitboards::RANK_2 : Bitboards::RANK_7;
+
+    switch (type) {
+        case EN_PASSANT:
+            return to == en_passant_sq && (Attacks::pawn_attacks[us][from] & to_bb);
+        case DOUBLE_PAWN_PUSH:
+            return ((1ULL << from) & double_rank) && to == from + 2 * push &&
+                   !(occupied & (1ULL << (from + push)));
+        case QUIET:
+        case CAPTURE:
+            if (to_bb & promo_rank) return false;
+            break;
+        default: // Promotions
+            if (!(to_bb & promo_rank)) return false;
+            break;
+    }
+    return is_capture ? (Attacks::pawn_attacks[us][from] & to_bb) != 0 : to == from + push;
+}
+
+bool Position::is_legal(Move m) const {
+    const Square from = Moves::get_from(m);
+    const Square to = Moves::get_to(m);
+    const MoveType type = Moves::get_type(m);
+    const Color them = (side_to_move == Color::WHITE) ? Color::BLACK : Color::WHITE;
+    const Bitboard occupied = color_bbs[0] | color_bbs[1];
+    const Bitboard enemies = color_bbs[static_cast<int>(them)];
+    const Square ksq = king_square(side_to_move);
+
+    // En passant removes two pieces from the board, which the pin masks do not
+    // model, so look for sliders on the king from scratch.
+    if (type == EN_PASSANT) {
+        const Square capture_sq = (side_to_move == Color::WHITE) ? static_cast<Square>(to - 8) : static_cast<Square>(to + 8);
+        const Bitboard occ_after = (occupied ^ (1ULL << from) ^ (1ULL << capture_sq)) | (1ULL << to);
+        const int t = static_cast<int>(them);
+        const Bitboard leapers = piece_bbs[t][static_cast<int>(PieceType::KNIGHT)] | piece_bbs[t][static_cast<int>(PieceType::PAWN)];
+        const Bitboard rook_like = piece_bbs[t][static_cast<int>(PieceType::ROOK)] | piece_bbs[t][static_cast<int>(PieceType::QUEEN)];
+        const Bitboard bishop_like = piece_bbs[t][static_cast<int>(PieceType::BISHOP)] | piece_bbs[t][static_cast<int>(PieceType::QUEEN)];
+        return !(checkers() & leapers & ~(1ULL << capture_sq)) &&
+               !(Attacks::get_rook_attacks(ksq, occ_after) & rook_like) &&
+               !(Attacks::get_bishop_attacks(ksq, occ_after) & bishop_like);
+    }
+
+    // The king may not step onto an attacked square; remove it from the board so
+    // that it cannot hide behind itself on a slider's line.
+    if (from == ksq) {
+        return !(attackers_to(to, occupied ^ (1ULL << from)) & enemies);
+    }
+
+    // With two checkers only the king can move; with one, the move must
+    // capture the checker or interpose.
+    const Bitboard check_mask = checkers();
+    if (check_mask) {
+        if (check_mask & (check_mask - 1)) return false;
+        if (!(Attacks::between_bb[ksq][__builtin_ctzll(check_mask)] & (1ULL << to))) return false;
+    }
+
+    // A pinned piece may only move along the pin line.
+    return !(blockers_for_king(side_to_move) & (1ULL << from)) || Attacks::aligned(from, to, ksq);
+}
+
+bool Position::is_draw(int ply) const {
+    // Checkmate takes precedence over the fifty-move rule.
+    if (halfmove_clock >= 100) {
+        if (!checkers()) return true;
+        MoveList move_list;
+        MoveGenerator::generate_moves(*this, move_list);
+        for (int i = 0; i < move_list.count; ++i) {
+            if (is_legal(move_list.moves[i])) return true;
+        }
+    }
+    return has_insufficient_material() || is_repetition(ply);
+}
+
+bool Position::is_repetition(int ply) const {
+    // Only positions since the last irreversible move can repeat, and only
+    // those with the same side to move, so every second entry is checked.
+    const int end = std::min(halfmove_clock, history_ply);
+    int count = 0;
+    for (int i = 4; i <= end; i += 2) {
+        if (history[history_ply - i].hash_key == hash_key) {
+            if (i < ply || ++count == 2) return true;
+        }
+    }
+    return false;
+}
+
+bool Position::has_insufficient_material() const {
+    const int w = static_cast<int>(Color::WHITE), b = static_cast<int>(Color::BLACK);
+    const int pawn = static_cast<int>(PieceType::PAWN), rook = static_cast<int>(PieceType::ROOK);
+    const int queen = static_cast<int>(PieceType::QUEEN);
+    if (piece_bbs[w][pawn] | piece_bbs[b][pawn] | piece_bbs[w][rook] | piece_bbs[b][rook] |
+        piece_bbs[w][queen] | piece_bbs[b][queen]) {
+        return false;
+    }
+
+    // Only kings and minor pieces remain. A single minor cannot mate, and
+    // neither can any number of bishops that all stand on one square color.
+    const Bitboard knights = piece_bbs[w][static_cast<int>(PieceType::KNIGHT)] | piece_bbs[b][static_cast<int>(PieceType::KNIGHT)];
+    const Bitboard bishops = piece_bbs[w][static_cast<int>(PieceType::BISHOP)] | piece_bbs[b][static_cast<int>(PieceType::BISHOP)];
+    const int minors = BB::count_bits(knights | bishops);
+    if (minors <= 1) return true;
+
+    constexpr Bitboard dark_squares = 0xAA55AA55AA55AA55ULL;
+    return !knights && (!(bishops & dark_squares) || !(bishops & ~dark_squares));
+}
+
+bool Position::has_upcoming_repetition(int ply) const {
+    const int end = std::min(halfmove_clock, history_ply);
+    if (end < 3) return false;
+
+    // key_at(k) is the key of the position k plies ago.
+    auto key_at = [this](int k) { return k == 0 ? hash_key : history[history_ply - k].hash_key; };
+    const Bitboard occupied = color_bbs[0] | color_bbs[1];
+    uint64_t other = key_at(0) ^ key_at(1) ^ Zobrist::black_to_move_key;
+
+    for (int i = 3; i <= end; i += 2) {
+        // 'other' becomes zero when the opponent's moves over the last i plies
+        // cancel out, leaving only our own piece displacement.
+        other ^= key_at(i - 1) ^ key_at(i) ^ Zobrist::black_to_move_key;
+        if (other != 0) continue;
+
+        const uint64_t move_key = key_at(0) ^ key_at(i);
+        int j = Zobrist::cuckoo_h1(move_key);
+        if (Zobrist::cuckoo_keys[j] != move_key) {
+            j = Zobrist::cuckoo_h2(move_key);
+            if (Zobrist::cuckoo_keys[j] != move_key) continue;
+        }
+
+        const Move move = Zobrist::cuckoo_moves[j];
+        const Square s1 = Moves::get_from(move);
+        const Square s2 = Moves::get_to(move);
+        if ((Attacks::between_bb[s1][s2] ^ (1ULL << s2)) & occupied) continue;
+
+        if (ply > i) return true;
+
+        // At or before the root, the earlier position must itself have occurred
+        // before, and the move must be ours rather than one leading here.
+        if (color_on_sq[color_on_sq[s1] == Color::NONE ? s2 : s1] != side_to_move) continue;
+        const int earlier_end = std::min(history[history_ply - i].halfmove_clock, history_ply - i);
+        for (int k = 4; k <= earlier_end; k += 2) {
+            if (key_at(i + k) == key_at(i)) return true;
+        }
+    }
+    return false;
+}
+
+void Position::compact_history() {
+    const int keep = std::min({halfmove_clock, history_ply, 100});
+    std::copy(history.begin() + (history_ply - keep), history.begin() + history_ply + 1, history.begin());
+    history_ply = keep;
+}
+
+uint64_t Position::key_after(Move m) const {
+    const Square from = Moves::get_from(m);
+    const Square to = Moves::get_to(m);
+    const MoveType type = Moves::get_type(m);
+    const int us = static_cast<int>(side_to_move);
+    const int them = 1 - us;
+    const int moved = static_cast<int>(piece_on_sq[from]);
+
+    uint64_t key = hash_key ^ Zobrist::black_to_move_key;
+    if (en_passant_sq != SQ_NONE) key ^= Zobrist::en_passant_keys[en_passant_sq % 8];
+
+    if (type == CAPTURE || type >= PROMO_CAPTURE_KNIGHT) {
+        key ^= Zobrist::piece_keys[them][static_cast<int>(piece_on_sq[to])][to];
+    } else if (type == EN_PASSANT) {
+        const int capture_sq = (us == static_cast<int>(Color::WHITE)) ? to - 8 : to + 8;
+        key ^= Zobrist::piece_keys[them][static_cast<int>(PieceType::PAWN)][capture_sq];
+    }
+
+    const int placed = (type >= PROMO_KNIGHT) ? ((type - PROMO_KNIGHT) % 4) + 1 : moved;
+    key ^= Zobrist::piece_keys[us][moved][from] ^ Zobrist::piece_keys[us][placed][to];
+
+    if (type == DOUBLE_PAWN_PUSH) {
+        key ^= Zobrist::en_passant_keys[to % 8];
+    } else if (type == KING_CASTLE || type == QUEEN_CASTLE) {
+        const int rook_from = (type == KING_CASTLE) ? to + 1 : to - 2;
+        const int rook_to = (type == KING_CASTLE) ? to - 1 : to + 1;
+        const int rook = static_cast<int>(PieceType::ROOK);
+        key ^= Zobrist::piece_keys[us][rook][rook_from] ^ Zobrist::piece_keys[us][rook][rook_to];
+    }
+
+    const uint8_t new_rights = castling_rights & castling_mask[from] & castling_mask[to];
+    if (new_rights != castling_rights) {
+        key ^= Zobrist::castling_keys[castling_rights] ^ Zobrist::castling_keys[new_rights];
+    }
+    return key;
+}
+
+bool Position::gives_check(Move m) const {
+    const Square from = Moves::get_from(m);
+    const Square to = Moves::get_to(m);
+    const MoveType type = Moves::get_type(m);
+    const int us = static_cast<int>(side_to_move);
+    const Color them = (side_to_move == Color::WHITE) ? Color::BLACK : Color::WHITE;
+    const Square ksq = king_square(them);
+    const Bitboard occupied = color_bbs[0] | color_bbs[1];
+    const Bitboard rook_like = piece_bbs[us][static_cast<int>(PieceType::ROOK)] | piece_bbs[us][static_cast<int>(PieceType::QUEEN)];
+    const Bitboard bishop_like = piece_bbs[us][static_cast<int>(PieceType::BISHOP)] | piece_bbs[us][static_cast<int>(PieceType::QUEEN)];
+
+    // Castling can only check through the rook, so test its destination directly.
+    if (type == KING_CASTLE || type == QUEEN_CASTLE) {
+        const Square rook_from = (type == KING_CASTLE) ? static_cast<Square>(to + 1) : static_cast<Square>(to - 2);
+        const Square rook_to = (type == KING_CASTLE) ? static_cast<Square>(to - 1) : static_cast<Square>(to + 1);
+        const Bitboard occ_after = occupied ^ (1ULL << from) ^ (1ULL << to) ^ (1ULL << rook_from) ^ (1ULL << rook_to);
+        return Attacks::get_rook_attacks(rook_to, occ_after) & (1ULL << ksq);
+    }
+
+    // Direct check by the moved piece.
+    if (check_squares(piece_on_sq[from]) & (1ULL << to)) return true;
+
+    // Discovered check by a slider behind the moved piece.
+    if ((blockers_for_king(them) & (1ULL << from)) && !Attacks::aligned(from, to, ksq)) return true;
+
+    if (type >= PROMO_KNIGHT) {
+        const PieceType promo_piece = static_cast<PieceType>(((type - PROMO_KNIGHT) % 4) + 1);
+        return Attacks::get_piece_attacks(promo_piece, to, occupied ^ (1ULL << from)) & (1ULL << ksq);
+    }
+
+    // En passant removes two pieces from the board, so a discovered check can
+    // come through either of them.
+    if (type == EN_PASSANT) {
+        const Square capture_sq = (side_to_move == Color::WHITE) ? static_cast<Square>(to - 8) : static_cast<Square>(to + 8);
+        const Bitboard occ_after = (occupied ^ (1ULL << from) ^ (1ULL << capture_sq)) | (1ULL << to);
+        return (Attacks::get_rook_attacks(ksq, occ_after) & rook_like) |
+               (Attacks::get_bishop_attacks(ksq, occ_after) & bishop_like);
+    }
+
+    return false;
+}
+
+Bitboard Position::attackers_to(Square s, Bitboard occupied) const {
+    const int w = static_cast<int>(Color::WHITE), b = static_cast<int>(Color::BLACK);
+    const Bitboard rook_like = piece_bbs[w][static_cast<int>(PieceType::ROOK)] | piece_bbs[b][static_cast<int>(PieceType::ROOK)] |
+                               piece_bbs[w][static_cast<int>(PieceType::QUEEN)] | piece_bbs[b][static_cast<int>(PieceType::QUEEN)];
+    const Bitboard bishop_like = piece_bbs[w][static_cast<int>(PieceType::BISHOP)] | piece_bbs[b][static_cast<int>(PieceType::BISHOP)] |
+                                 piece_bbs[w][static_cast<int>(PieceType::QUEEN)] | piece_bbs[b][static_cast<int>(PieceType::QUEEN)];
+    return (Attacks::pawn_attacks[b][s] & piece_bbs[w][static_cast<int>(PieceType::PAWN)]) |
+           (Attacks::pawn_attacks[w][s] & piece_bbs[b][static_cast<int>(PieceType::PAWN)]) |
+           (Attacks::knight_attacks[s] & (piece_bbs[w][static_cast<int>(PieceType::KNIGHT)] | piece_bbs[b][static_cast<int>(PieceType::KNIGHT)])) |
+           (Attacks::king_attacks[s] & (piece_bbs[w][static_cast<int>(PieceType::KING)] | piece_bbs[b][static_cast<int>(PieceType::KING)])) |
+           (Attacks::get_rook_attacks(s, occupied) & rook_like) |
+           (Attacks::get_bishop_attacks(s, occupied) & bishop_like);
+}
+
+Bitboard Position::slider_blockers(Bitboard sliders, Square s, Bitboard& pinners) const {
+    Bitboard blockers = 0ULL;
+    pinners = 0ULL;
+
+    // Snipers are sliders that would attack s on an empty board.
+    const Bitboard rook_like = sliders & (piece_bbs[0][static_cast<int>(PieceType::ROOK)] | piece_bbs[1][static_cast<int>(PieceType::ROOK)] |
+                                          piece_bbs[0][static_cast<int>(PieceType::QUEEN)] | piece_bbs[1][static_cast<int>(PieceType::QUEEN)]);
+    const Bitboard bishop_like = sliders & (piece_bbs[0][static_cast<int>(PieceType::BISHOP)] | piece_bbs[1][static_cast<int>(PieceType::BISHOP)] |
+                                            piece_bbs[0][static_cast<int>(PieceType::QUEEN)] | piece_bbs[1][static_cast<int>(PieceType::QUEEN)]);
+    Bitboard snipers = (Attacks::get_rook_attacks(s, 0ULL) & rook_like) | (Attacks::get_bishop_attacks(s, 0ULL) & bishop_like);
+    const Bitboard occupancy = (color_bbs[0] | color_bbs[1]) ^ snipers;
+    const Bitboard own_pieces = color_bbs[static_cast<int>(color_on_sq[s])];
+
+    while (snipers) {
+        const Square sniper_sq = BB::pop_lsb(snipers);
+        const Bitboard b = Attacks::between_bb[s][sniper_sq] & occupancy;
+        if (b && !(b & (b - 1))) {
+            blockers |= b;
+            if (b & own_pieces) pinners |= 1ULL << sniper_sq;
+        }
+    }
+    return blockers;
+}
+
+void Position::set_check_info() {
+    StateInfo& st = history[history_ply];
+    const int us = static_cast<int>(side_to_move);
+    const int them = 1 - us;
+
+    st.checkers = 0ULL;
+    for (Bitboard& bb : st.blockers_for_king) bb = 0ULL;
+    for (Bitboard& bb : st.pinners) bb = 0ULL;
+    for (Bitboard& bb : st.check_squares) bb = 0ULL;
+
+    // Hand-built positions may lack a king; leave the masks empty in that case.
+    if (!piece_bbs[us][static_cast<int>(PieceType::KING)] || !piece_bbs[them][static_cast<int>(PieceType::KING)]) return;
+
+    const Square our_king = king_square(side_to_move);
+    const Square their_king = king_square(static_cast<Color>(them));
+    const Bitboard occupied = color_bbs[0] | color_bbs[1];
+
+    st.checkers = attackers_to(our_king, occupied) & color_bbs[them];
+    st.blockers_for_king[us] = slider_blockers(color_bbs[them], our_king, st.pinners[them]);
+    st.blockers_for_king[them] = slider_blockers(color_bbs[us], their_king, st.pinners[us]);
+
+    st.check_squares[static_cast<int>(PieceType::PAWN)] = Attacks::pawn_attacks[them][their_king];
+    st.check_squares[static_cast<int>(PieceType::KNIGHT)] = Attacks::knight_attacks[their_king];
+    st.check_squares[static_cast<int>(PieceType::BISHOP)] = Attacks::get_bishop_attacks(their_king, occupied);
+    st.check_squares[static_cast<int>(PieceType::ROOK)] = Attacks::get_rook_attacks(their_king, occupied);
+    st.check_squares[static_cast<int>(PieceType::QUEEN)] =
+        st.check_squares[static_cast<int>(PieceType::BISHOP)] | st.check_squares[static_cast<int>(PieceType::ROOK)];
+}
+
 static void set_piece(Position& pos, Square s, PieceType pt, Color c, bool is_add) {
     Bitboard s_bb = 1ULL << s;
     pos.piece_on_sq[s] = is_add ? pt : PieceType::NONE;
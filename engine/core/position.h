@@ -4,10 +4,41 @@
 #include "bitboard/bitboard.h"
 #include "zobrist/zobrist.h"
 #include <string>
+#include <string_view>
 #include <array>
 
 namespace aetherchess {
 
+class TranspositionTable;
+
+// Reasons a FEN or EPD record can be rejected by Position::set_from_fen.
+enum class FenError : uint8_t {
+    NONE,
+    BAD_PIECE,
+    BAD_RANK_LENGTH,
+    BAD_RANK_COUNT,
+    PAWN_ON_BACK_RANK,
+    BAD_KING_COUNT,
+    BAD_SIDE_TO_MOVE,
+    BAD_CASTLING,
+    BAD_EN_PASSANT,
+    BAD_HALFMOVE_CLOCK,
+    BAD_FULLMOVE_NUMBER,
+    OPPONENT_IN_CHECK
+};
+
+// Outcome of parsing a record. On success 'offset' is the index just past the
+// last consumed field, where EPD operations begin; on failure it points at the
+// offending character.
+struct FenResult {
+    FenError error = FenError::NONE;
+    size_t offset = 0;
+
+    explicit operator bool() const { return error == FenError::NONE; }
+};
+
+const char* fen_error_string(FenError e);
+
 // The Position struct represents a single, static chess position.
 // It contains all the information needed to generate legal moves, evaluate the
 // position, and continue the game.
@@ -35,26 +66,107 @@ struct Position {
     // The Zobrist hash key for the current position.
     uint64_t hash_key = 0;
 
+    // Optional table whose bucket for the child key is prefetched by make_move,
+    // so the line is in cache by the time the child position probes it.
+    const TranspositionTable* tt = nullptr;
+
     // --- Member Functions ---
 
     // --- State History & Undo Information ---
+    // history[history_ply] describes the current position. The check info is
+    // computed once when the position is reached and stays valid until the
+    // entry is overwritten by a later move from the same ply.
     struct StateInfo {
         CastlingRights castling_rights;
         Square en_passant_sq;
         int halfmove_clock;
         PieceType captured_piece;
         uint64_t hash_key;
+
+        // Enemy pieces giving check to the side to move.
+        Bitboard checkers;
+        // Pieces of either color that shield each king from an enemy slider.
+        // Indexed by the [Color] of the king.
+        Bitboard blockers_for_king[2];
+        // Sliders of the given [Color] that pin a piece against the enemy king.
+        Bitboard pinners[2];
+        // Squares from which a piece of the side to move would give direct check.
+        // Indexed by [PieceType].
+        Bitboard check_squares[6];
     };
     std::array<StateInfo, 256> history;
     int history_ply = 0;
 
     // --- Member Functions ---
-    void set_from_fen(const std::string& fen_string);
+    // Parses a FEN record, or the first four fields of an EPD record (the move
+    // counters then default to 0 and 1). Allocates nothing and never throws;
+    // the board is unspecified if an error is returned.
+    FenResult set_from_fen(std::string_view fen);
+    std::string to_fen() const;
     bool make_move(Move m);
     void unmake_move(Move m);
     bool is_in_check(Color c) const;
     bool is_square_attacked(Square s, Color attacker_color) const;
 
+    // Validates a move from an untrusted source (hash table, killer slot, GUI)
+    // directly against the bitboards. True exactly when generate_moves would
+    // produce m in this position.
+    bool is_pseudo_legal(Move m) const;
+
+    // Returns true if the pseudo-legal move m does not leave our king in check.
+    // Uses the cached check info instead of making the move.
+    bool is_legal(Move m) const;
+
+    // Returns true if the position is drawn by the fifty-move rule, insufficient
+    // material or repetition. 'ply' is the distance from the search root: a
+    // repetition inside the search counts at once, one that reaches back past
+    // the root needs a third occurrence.
+    bool is_draw(int ply) const;
+    bool is_repetition(int ply) const;
+    bool has_insufficient_material() const;
+
+    // Returns true if the side to move can reach an earlier position with a
+    // single reversible move, so the search can score the cycle as a draw
+    // before playing into it. Uses the Zobrist cuckoo tables.
+    bool has_upcoming_repetition(int ply) const;
+
+    // Drops the history entries before the last irreversible move, since they
+    // can no longer repeat. Lets a long game history fit into 'history'.
+    void compact_history();
+
+    // Returns the Zobrist key of the position after the pseudo-legal move m,
+    // derived incrementally without making the move.
+    uint64_t key_after(Move m) const;
+
+    // Returns true if the pseudo-legal move m checks the opponent's king.
+    // Uses the cached check info, so the move does not have to be made.
+    bool gives_check(Move m) const;
+
+    // Bitboard of all pieces of both colors attacking square s.
+    Bitboard attackers_to(Square s, Bitboard occupied) const;
+
+    // Returns the pieces that block a slider in 'sliders' from attacking s.
+    // Sliders that pin a piece of the same color as the piece on s are
+    // returned through 'pinners'.
+    Bitboard slider_blockers(Bitboard sliders, Square s, Bitboard& pinners) const;
+
+    // Recomputes the check info of the current history entry.
+    void set_check_info();
+
+    const StateInfo& state() const { return history[history_ply]; }
+    Bitboard checkers() const { return history[history_ply].checkers; }
+    Bitboard blockers_for_king(Color c) const {
+        return history[history_ply].blockers_for_king[static_cast<int>(c)];
+    }
+    Bitboard check_squares(PieceType pt) const {
+        return history[history_ply].check_squares[static_cast<int>(pt)];
+    }
+
+    Square king_square(Color c) const {
+        return static_cast<Square>(
+            __builtin_ctzll(piece_bbs[static_cast<int>(c)][static_cast<int>(PieceType::KING)]));
+    }
+
     // Calculates the Zobrist hash from scratch based on the current board state.
     uint64_t calculate_hash() const {
         uint64_t hash = 0;
@@ -0,0 +1,146 @@
+#include "san.h"
+#include "../movegen/movegen.h"
+
+namespace aetherchess {
+namespace SAN {
+
+static PieceType piece_from_char(char c) {
+    switch (c) {
+        case 'N': return PieceType::KNIGHT;
+        case 'B': return PieceType::BISHOP;
+        case 'R': return PieceType::ROOK;
+        case 'Q': return PieceType::QUEEN;
+        case 'K': return PieceType::KING;
+        default:  return PieceType::NONE;
+    }
+}
+
+Move to_move(const Position& pos, std::string_view san) {
+    while (!san.empty() && (san.back() == '+' || san.back() == '#' || san.back() == '!' || san.back() == '?')) {
+        san.remove_suffix(1);
+    }
+
+    MoveList move_list;
+    MoveGenerator::generate_moves(pos, move_list);
+
+    if (san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0") {
+        const MoveType castle = san.size() == 3 ? KING_CASTLE : QUEEN_CASTLE;
+        for (int i = 0; i < move_list.count; ++i) {
+            const Move m = move_list.moves[i];
+            if (Moves::get_type(m) == castle && pos.is_legal(m)) return m;
+        }
+        return MOVE_NONE;
+    }
+
+    PieceType pt = PieceType::PAWN;
+    if (!san.empty() && piece_from_char(san.front()) != PieceType::NONE) {
+        pt = piece_from_char(san.front());
+        san.remove_prefix(1);
+    }
+
+    PieceType promo = PieceType::NONE;
+    if (san.size() >= 2 && san[san.size() - 2] == '=') {
+        promo = piece_from_char(san.back());
+        if (promo == PieceType::NONE || promo == PieceType::KING) return MOVE_NONE;
+        san.remove_suffix(2);
+    } else if (pt == PieceType::PAWN && !san.empty() && piece_from_char(san.back()) != PieceType::NONE) {
+        promo = piece_from_char(san.back());
+        san.remove_suffix(1);
+    }
+
+    if (san.size() < 2) return MOVE_NONE;
+    const char to_file = san[san.size() - 2], to_rank = san[san.size() - 1];
+    if (to_file < 'a' || to_file > 'h' || to_rank < '1' || to_rank > '8') return MOVE_NONE;
+    const Square to = static_cast<Square>((to_rank - '1') * 8 + (to_file - 'a'));
+    san.remove_suffix(2);
+
+    // What is left is optional disambiguation and the capture marker.
+    int from_file = -1, from_rank = -1;
+    for (char c : san) {
+        if (c >= 'a' && c <= 'h') from_file = c - 'a';
+        else if (c >= '1' && c <= '8') from_rank = c - '1';
+        else if (c != 'x' && c != ':' && c != '-') return MOVE_NONE;
+    }
+
+    Move found = MOVE_NONE;
+    for (int i = 0; i < move_list.count; ++i) {
+        const Move m = move_list.moves[i];
+        const Square from = Moves::get_from(m);
+        const MoveType type = Moves::get_type(m);
+        if (Moves::get_to(m) != to || pos.piece_on_sq[from] != pt) continue;
+        if (type == KING_CASTLE || type == QUEEN_CASTLE) continue;
+        if (from_file >= 0 && from % 8 != from_file) continue;
+        if (from_rank >= 0 && from / 8 != from_rank) continue;
+
+        const PieceType move_promo = (type >= PROMO_KNIGHT)
+            ? static_cast<PieceType>(((type - PROMO_KNIGHT) % 4) + 1) : PieceType::NONE;
+        if (move_promo != promo) continue;
+        if (!pos.is_legal(m)) continue;
+
+        if (found != MOVE_NONE) return MOVE_NONE; // Ambiguous
+        found = m;
+    }
+    return found;
+}
+
+std::string to_string(Position& pos, Move m) {
+    const Square from = Moves::get_from(m);
+    const Square to = Moves::get_to(m);
+    const MoveType type = Moves::get_type(m);
+    const PieceType pt = pos.piece_on_sq[from];
+    const bool capture = type == CAPTURE || type == EN_PASSANT || type >= PROMO_CAPTURE_KNIGHT;
+    static constexpr char piece_chars[6] = {'P', 'N', 'B', 'R', 'Q', 'K'};
+
+    std::string san;
+    if (type == KING_CASTLE) {
+        san = "O-O";
+    } else if (type == QUEEN_CASTLE) {
+        san = "O-O-O";
+    } else {
+        if (pt == PieceType::PAWN) {
+            if (capture) san += static_cast<char>('a' + from % 8);
+        } else {
+            san += piece_chars[static_cast<int>(pt)];
+
+            // Disambiguate against other pieces of the same type that can legally reach 'to'.
+            MoveList move_list;
+            MoveGenerator::generate_moves(pos, move_list);
+            bool ambiguous = false, same_file = false, same_rank = false;
+            for (int i = 0; i < move_list.count; ++i) {
+                const Move other = move_list.moves[i];
+                const Square other_from = Moves::get_from(other);
+                if (other_from == from || Moves::get_to(other) != to || pos.piece_on_sq[other_from] != pt) continue;
+                if (!pos.is_legal(other)) continue;
+                ambiguous = true;
+                same_file |= other_from % 8 == from % 8;
+                same_rank |= other_from / 8 == from / 8;
+            }
+            if (ambiguous) {
+                if (!same_file) san += static_cast<char>('a' + from % 8);
+                else if (!same_rank) san += static_cast<char>('1' + from / 8);
+                else { san += static_cast<char>('a' + from % 8); san += static_cast<char>('1' + from / 8); }
+            }
+        }
+        if (capture) san += 'x';
+        san += static_cast<char>('a' + to % 8);
+        san += static_cast<char>('1' + to / 8);
+        if (type >= PROMO_KNIGHT) {
+            san += '=';
+            san += piece_chars[((type - PROMO_KNIGHT) % 4) + 1];
+        }
+    }
+
+    if (pos.gives_check(m)) {
+        bool has_reply = false;
+        pos.make_move(m);
+        MoveList replies;
+        MoveGenerator::generate_moves(pos, replies);
+        for (int i = 0; i < replies.count && !has_reply; ++i) has_reply = pos.is_legal(replies.moves[i]);
+        pos.unmake_move(m);
+        san += has_reply ? '+' : '#';
+    }
+    return san;
+}
+
+} // namespace SAN
+} // namespace aetherchess
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "position.h"
+#include <string>
+#include <string_view>
+
+namespace aetherchess {
+namespace SAN {
+
+// Converts a move in Standard Algebraic Notation (e.g. "Nbd7", "exd5", "e8=Q+",
+// "O-O") to the engine's encoding by matching it against the legal moves of
+// pos. Check and annotation suffixes are ignored. Returns MOVE_NONE if the
+// text matches no legal move or is ambiguous.
+Move to_move(const Position& pos, std::string_view san);
+
+// Formats the legal move m in SAN, with the minimal disambiguation and a '+'
+// or '#' suffix. The move is made and unmade on pos to detect mate, so pos is
+// taken by reference but left unchanged.
+std::string to_string(Position& pos, Move m);
+
+} // namespace SAN
+} // namespace aetherchess
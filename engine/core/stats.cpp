@@ -0,0 +1,89 @@
+#include "stats.h"
+#include <iomanip>
+#include <sstream>
+
+namespace aetherchess {
+namespace Stats {
+
+static constexpr const char* counter_names[COUNTER_NB] = {
+    "search_nodes", "qsearch_nodes", "tt_probes", "tt_hits", "tt_cutoffs", "beta_cutoffs",
+    "first_move_cutoffs", "mate_distance_prunes", "repetition_prunes", "tablebase_hits",
+    "lmr_reductions", "lmr_researches", "pvs_researches", "stand_pat_cutoffs", "make_moves",
+    "illegal_moves", "unmake_moves", "generate_calls", "generated_moves", "evaluations",
+    "eval_cache_probes", "eval_cache_hits"};
+
+static constexpr const char* phase_names[PHASE_NB] = {"movegen", "eval", "tablebase"};
+
+static double ratio(uint64_t num, uint64_t den) {
+    return den ? static_cast<double>(num) / static_cast<double>(den) : 0.0;
+}
+
+Counters& Counters::operator+=(const Counters& other) {
+    for (int i = 0; i < COUNTER_NB; ++i) counts[i] += other.counts[i];
+    for (int i = 0; i < PHASE_NB; ++i) phase_ns[i] += other.phase_ns[i];
+    for (int i = 0; i < MAX_ITERATIONS; ++i) iteration_nodes[i] += other.iteration_nodes[i];
+    return *this;
+}
+
+double Counters::branching_factor() const {
+    for (int d = MAX_ITERATIONS - 1; d > 1; --d) {
+        if (iteration_nodes[d]) return ratio(iteration_nodes[d], iteration_nodes[d - 1]);
+    }
+    return 0.0;
+}
+
+Counters take() {
+#ifdef AETHERCHESS_STATS
+    const Counters c = local;
+    local = {};
+    return c;
+#else
+    return {};
+#endif
+}
+
+void print_info(std::ostream& os, const Counters& c) {
+    const uint64_t nodes = c[SEARCH_NODES] + c[QSEARCH_NODES];
+    os << std::fixed << std::setprecision(1);
+    if (nodes) {
+        os << "info string stats nodes " << nodes << " qsearch " << 100 * ratio(c[QSEARCH_NODES], nodes)
+           << "% ebf " << std::setprecision(2) << c.branching_factor() << std::setprecision(1)
+           << " tthit " << 100 * ratio(c[TT_HITS], c[TT_PROBES]) << "% ttcut " << c[TT_CUTOFFS]
+           << " firstcut " << 100 * ratio(c[FIRST_MOVE_CUTOFFS], c[BETA_CUTOFFS]) << "%\n";
+        os << "info string stats pruning mdp " << c[MATE_DISTANCE_PRUNES] << " rep " << c[REPETITION_PRUNES]
+           << " tb " << c[TABLEBASE_HITS] << " lmr " << c[LMR_REDUCTIONS] << " lmr_research "
+           << c[LMR_RESEARCHES] << " pvs_research " << c[PVS_RESEARCHES] << " standpat "
+           << c[STAND_PAT_CUTOFFS] << "\n";
+    }
+    os << "info string stats make " << c[MAKE_MOVES] << " illegal " << c[ILLEGAL_MOVES] << " unmake "
+       << c[UNMAKE_MOVES] << " movegen " << c[GENERATE_CALLS] << " moves/gen "
+       << ratio(c[GENERATED_MOVES], c[GENERATE_CALLS]) << " evals " << c[EVALUATIONS] << " evalcache "
+       << 100 * ratio(c[EVAL_CACHE_HITS], c[EVAL_CACHE_PROBES]) << "%\n";
+    os << "info string stats time_ms";
+    for (int p = 0; p < PHASE_NB; ++p) os << " " << phase_names[p] << " " << c.phase_ns[p] / 1e6;
+    os << std::defaultfloat << std::endl;
+}
+
+std::string to_json(const Counters& c) {
+    const uint64_t nodes = c[SEARCH_NODES] + c[QSEARCH_NODES];
+    std::ostringstream os;
+    os << "{\"counters\":{";
+    for (int i = 0; i < COUNTER_NB; ++i) os << (i ? "," : "") << "\"" << counter_names[i] << "\":" << c.counts[i];
+    os << "},\"phase_ns\":{";
+    for (int p = 0; p < PHASE_NB; ++p) os << (p ? "," : "") << "\"" << phase_names[p] << "\":" << c.phase_ns[p];
+    os << "},\"iteration_nodes\":[";
+    int last = MAX_ITERATIONS - 1;
+    while (last > 0 && !c.iteration_nodes[last]) --last;
+    for (int d = 1; d <= last; ++d) os << (d > 1 ? "," : "") << c.iteration_nodes[d];
+    os << "],\"derived\":{"
+       << "\"tt_hit_rate\":" << ratio(c[TT_HITS], c[TT_PROBES])
+       << ",\"eval_cache_hit_rate\":" << ratio(c[EVAL_CACHE_HITS], c[EVAL_CACHE_PROBES])
+       << ",\"first_move_cutoff_rate\":" << ratio(c[FIRST_MOVE_CUTOFFS], c[BETA_CUTOFFS])
+       << ",\"qsearch_share\":" << ratio(c[QSEARCH_NODES], nodes)
+       << ",\"effective_branching_factor\":" << c.branching_factor()
+       << ",\"moves_per_generate\":" << ratio(c[GENERATED_MOVES], c[GENERATE_CALLS]) << "}}";
+    return os.str();
+}
+
+} // namespace Stats
+} // namespace aetherchess
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Search and move generation statistics.
+//
+// The counters only exist when the engine is configured with
+// -DAETHERCHESS_STATS=ON. Otherwise every STATS_* macro expands to nothing and
+// its arguments are not evaluated, so the hot paths compile to the same code
+// as without instrumentation.
+//
+// Each thread counts into its own thread_local Counters without any
+// synchronisation; whoever owns the thread collects them with take() at the
+// end of a search or perft run and sums them with operator+=.
+
+namespace aetherchess {
+namespace Stats {
+
+#ifdef AETHERCHESS_STATS
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+enum Counter : int {
+    SEARCH_NODES,           // negamax calls
+    QSEARCH_NODES,          // qsearch calls
+    TT_PROBES,
+    TT_HITS,
+    TT_CUTOFFS,             // nodes answered by the TT bound alone
+    BETA_CUTOFFS,           // fail-high nodes in negamax
+    FIRST_MOVE_CUTOFFS,     // ... of which failed high on the first legal move
+    MATE_DISTANCE_PRUNES,
+    REPETITION_PRUNES,      // upcoming-repetition cutoffs
+    TABLEBASE_HITS,
+    LMR_REDUCTIONS,
+    LMR_RESEARCHES,         // reduced searches that had to be repeated
+    PVS_RESEARCHES,         // null-window searches repeated with the full window
+    STAND_PAT_CUTOFFS,
+    MAKE_MOVES,
+    ILLEGAL_MOVES,          // make_move calls rejected by the legality check
+    UNMAKE_MOVES,
+    GENERATE_CALLS,
+    GENERATED_MOVES,
+    EVALUATIONS,            // evaluate() calls that were not answered by the eval cache
+    EVAL_CACHE_PROBES,
+    EVAL_CACHE_HITS,
+    COUNTER_NB
+};
+
+enum Phase : int { PHASE_MOVEGEN, PHASE_EVAL, PHASE_TABLEBASE, PHASE_NB };
+
+// Deepest iteration whose node count is kept for the branching factor.
+constexpr int MAX_ITERATIONS = 128;
+
+struct Counters {
+    uint64_t counts[COUNTER_NB] = {};
+    uint64_t phase_ns[PHASE_NB] = {};
+    // Nodes spent on each completed iteration of iterative deepening.
+    uint64_t iteration_nodes[MAX_ITERATIONS] = {};
+
+    uint64_t operator[](Counter c) const { return counts[c]; }
+    Counters& operator+=(const Counters& other);
+
+    // Nodes of the deepest completed iteration divided by those of the one
+    // before it; 0 if fewer than two iterations completed.
+    double branching_factor() const;
+};
+
+#ifdef AETHERCHESS_STATS
+inline thread_local Counters local;
+
+// Adds the time from construction to destruction to a phase.
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Phase phase) : phase(phase), start(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() {
+        local.phase_ns[phase] += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                           std::chrono::steady_clock::now() - start).count());
+    }
+
+private:
+    Phase phase;
+    std::chrono::steady_clock::time_point start;
+};
+
+#define STATS_INC(counter) (++::aetherchess::Stats::local.counts[::aetherchess::Stats::counter])
+#define STATS_ADD(counter, n) (::aetherchess::Stats::local.counts[::aetherchess::Stats::counter] += (n))
+#define STATS_ITERATION(depth, n) (::aetherchess::Stats::local.iteration_nodes[(depth) % ::aetherchess::Stats::MAX_ITERATIONS] += (n))
+#define STATS_TIMER(phase) ::aetherchess::Stats::ScopedTimer stats_timer_(::aetherchess::Stats::phase)
+#else
+#define STATS_INC(counter) ((void)0)
+#define STATS_ADD(counter, n) ((void)0)
+#define STATS_ITERATION(depth, n) ((void)0)
+#define STATS_TIMER(phase) ((void)0)
+#endif
+
+// Returns the calling thread's counters and resets them. Always empty when
+// statistics are compiled out.
+Counters take();
+
+// Writes the summary as UCI "info string" lines.
+void print_info(std::ostream& os, const Counters& c);
+
+// Returns the raw counters and the derived ratios as a JSON object.
+std::string to_json(const Counters& c);
+
+} // namespace Stats
+} // namespace aetherchess
@@ -49,7 +49,7 @@ enum CastlingRights : uint8_t {
     ANY_CASTLING = WHITE_KINGSIDE | WHITE_QUEENSIDE | BLACK_KINGSIDE | BLACK_QUEENSIDE
 };
 
-// A move is packed into a 32-bit integer for efficiency.
+// A move is packed into a 16-bit integer, so move lists and hash entries stay small.
 //
 // Bits | Description
 // -----|--------------------------------------------------
@@ -58,11 +58,14 @@ enum CastlingRights : uint8_t {
 // 12-15| Move flags (see MoveType enum)
 //
 // The promotion piece is encoded within the flags.
-using Move = uint32_t;
+using Move = uint16_t;
+
+// A1 to A1 is never a valid move, so the all-zero value doubles as "no move".
+constexpr Move MOVE_NONE = 0;
 
 // The MoveType enum defines all possible types of moves.
 // The 4-bit value is stored in the move's flags.
-enum MoveType : uint32_t {
+enum MoveType : uint16_t {
     QUIET            = 0b0000,
     DOUBLE_PAWN_PUSH = 0b0001,
     KING_CASTLE      = 0b0010,
@@ -83,7 +86,7 @@ enum MoveType : uint32_t {
 // Helper functions for creating and decoding moves.
 namespace Moves {
     inline Move create(Square from, Square to, MoveType type = QUIET) {
-        return (type << 12) | (to << 6) | from;
+        return static_cast<Move>((type << 12) | (to << 6) | from);
     }
 
     inline Square get_from(Move m) { return static_cast<Square>(m & 0x3F); }
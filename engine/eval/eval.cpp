@@ -1,82 +1,13 @@
 #include "eval.h"
 #include "../core/position.h"
+#include "../core/stats.h"
+#include "../movegen/attack_map.h"
+#include "../movegen/attacks.h"
+#include "eval_params.h"
 
 namespace aetherchess {
 namespace Eval {
 
-// Piece-Square Tables (PSTs)
-// These tables score a piece based on its position on the board.
-// The values are in centipawns. They are defined from white's perspective.
-// For black, the square index is flipped.
-
-const int pawn_pst[64] = {
-     0,  0,  0,  0,  0,  0,  0,  0,
-    50, 50, 50, 50, 50, 50, 50, 50,
-    10, 10, 20, 30, 30, 20, 10, 10,
-     5,  5, 10, 25, 25, 10,  5,  5,
-     0,  0,  0, 20, 20,  0,  0,  0,
-     5, -5,-10,  0,  0,-10, -5,  5,
-     5, 10, 10,-20,-20, 10, 10,  5,
-     0,  0,  0,  0,  0,  0,  0,  0
-};
-
-const int knight_pst[64] = {
-    -50,-40,-30,-30,-30,-30,-40,-50,
-    -40,-20,  0,  0,  0,  0,-20,-40,
-    -30,  0, 10, 15, 15, 10,  0,-30,
-    -30,  5, 15, 20, 20, 15,  5,-30,
-    -30,  0, 15, 20, 20, 15,  0,-30,
-    -30,  5, 10, 15, 15, 10,  5,-30,
-    -40,-20,  0,  5,  5,  0,-20,-40,
-    -50,-40,-30,-30,-30,-30,-40,-50,
-};
-
-const int bishop_pst[64] = {
-    -20,-10,-10,-10,-10,-10,-10,-20,
-    -10,  0,  0,  0,  0,  0,  0,-10,
-    -10,  0,  5, 10, 10,  5,  0,-10,
-    -10,  5,  5, 10, 10,  5,  5,-10,
-    -10,  0, 10, 10, 10, 10,  0,-10,
-    -10, 10, 10, 10, 10, 10, 10,-10,
-    -10,  5,  0,  0,  0,  0,  5,-10,
-    -20,-10,-10,-10,-10,-10,-10,-20,
-};
-
-const int rook_pst[64] = {
-      0,  0,  0,  0,  0,  0,  0,  0,
-      5, 10, 10, 10, 10, 10, 10,  5,
-     -5,  0,  0,  0,  0,  0,  0, -5,
-     -5,  0,  0,  0,  0,  0,  0, -5,
-     -5,  0,  0,  0,  0,  0,  0, -5,
-     -5,  0,  0,  0,  0,  0,  0, -5,
-     -5,  0,  0,  0,  0,  0,  0, -5,
-      0,  0,  0,  5,  5,  0,  0,  0
-};
-
-const int queen_pst[64] = {
-    -20,-10,-10, -5, -5,-10,-10,-20,
-    -10,  0,  0,  0,  0,  0,  0,-10,
-    -10,  0,  5,  5,  5,  5,  0,-10,
-     -5,  0,  5,  5,  5,  5,  0, -5,
-      0,  0,  5,  5,  5,  5,  0, -5,
-    -10,  5,  5,  5,  5,  5,  0,-10,
-    -10,  0,  5,  0,  0,  0,  0,-10,
-    -20,-10,-10, -5, -5,-10,-10,-20
-};
-
-const int king_pst[64] = {
-    -30,-40,-40,-50,-50,-40,-40,-30,
-    -30,-40,-40,-50,-50,-40,-40,-30,
-    -30,-40,-40,-50,-50,-40,-40,-30,
-    -30,-40,-40,-50,-50,-40,-40,-30,
-    -20,-30,-30,-40,-40,-30,-30,-20,
-    -10,-20,-20,-20,-20,-20,-20,-10,
-     20, 20,  0,  0,  0,  0, 20, 20,
-     20, 30, 10,  0,  0, 10, 30, 20
-};
-
-const int material_values[6] = {100, 320, 330, 500, 900, 20000}; // PAWN to KING
-
 static int calculate_material(const Position& pos) {
     int score = 0;
     for (int pt_idx = 0; pt_idx < 6; ++pt_idx) {
@@ -85,8 +16,38 @@ static int calculate_material(const Position& pos) {
     return score;
 }
 
+// Mobility, king-zone attacks and hanging pieces of one side, from the attack
+// maps of both sides.
+static int calculate_activity(const Position& pos, const Attacks::AttackMap& attacks, Color us) {
+    const int c = static_cast<int>(us), them = c ^ 1;
+    const Bitboard safe = ~pos.color_bbs[c] & ~attacks.by_type[them][static_cast<int>(PieceType::PAWN)];
+
+    const Bitboard their_king = pos.piece_bbs[them][static_cast<int>(PieceType::KING)];
+    const Bitboard king_zone = their_king ? Attacks::king_attacks[__builtin_ctzll(their_king)] | their_king : 0ULL;
+
+    int score = 0;
+    for (int pt = static_cast<int>(PieceType::KNIGHT); pt <= static_cast<int>(PieceType::QUEEN); ++pt) {
+        score += mobility_weights[pt] * BB::count_bits(attacks.by_type[c][pt] & safe);
+        score += king_attack_weights[pt] * BB::count_bits(attacks.by_type[c][pt] & king_zone);
+    }
+
+    const Bitboard pieces = pos.color_bbs[c] & ~pos.piece_bbs[c][static_cast<int>(PieceType::PAWN)] &
+                            ~pos.piece_bbs[c][static_cast<int>(PieceType::KING)];
+    score -= hanging_piece_penalty * BB::count_bits(pieces & attacks.by_color[them] & ~attacks.by_color[c]);
+    return score;
+}
+
+// The activity terms of both sides, from white's perspective.
+static int calculate_activity(const Position& pos) {
+    // The attack maps are computed once and shared by the activity terms.
+    Attacks::AttackMap attacks;
+    Attacks::compute_attack_map(pos, attacks);
+    return calculate_activity(pos, attacks, Color::WHITE) - calculate_activity(pos, attacks, Color::BLACK);
+}
 
 int evaluate(const Position& pos) {
+    STATS_TIMER(PHASE_EVAL);
+    STATS_INC(EVALUATIONS);
     int score = calculate_material(pos);
 
     const int* psts[] = {pawn_pst, knight_pst, bishop_pst, rook_pst, queen_pst, king_pst};
@@ -105,9 +66,16 @@ int evaluate(const Position& pos) {
         }
     }
 
+    score += calculate_activity(pos);
+
     // Return score from the perspective of the side to move
     return (pos.side_to_move == Color::WHITE) ? score : -score;
 }
 
+int evaluate_activity(const Position& pos) {
+    const int score = calculate_activity(pos);
+    return (pos.side_to_move == Color::WHITE) ? score : -score;
+}
+
 } // namespace Eval
 } // namespace aetherchess
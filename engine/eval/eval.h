@@ -10,5 +10,9 @@ namespace Eval {
 // The score is in centipawns.
 int evaluate(const Position& pos);
 
+// The activity part of evaluate (mobility, king-zone attacks and hanging
+// pieces), from the same perspective. The tuner holds it fixed.
+int evaluate_activity(const Position& pos);
+
 } // namespace Eval
 } // namespace aetherchess
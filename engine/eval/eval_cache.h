@@ -0,0 +1,61 @@
+#pragma once
+
+#include "eval.h"
+#include "../core/stats.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace aetherchess {
+namespace Eval {
+
+// A direct-mapped cache of static evaluations, owned by one search thread.
+// Each entry is one word: the upper 48 bits of the position's hash key and
+// the 16-bit score. The low bits of the key select the slot, so the whole key
+// is checked only with 65536 or more entries. The default 32768 leave bit 15
+// unchecked, and every halving one more bit. Another position in the slot is
+// still mistaken for this one only if its upper 48 bits match. The default
+// 256 KB stays in L2 next to the search.
+class EvalCache {
+public:
+    static constexpr size_t DEFAULT_ENTRIES = 32768;
+
+    // 'entries' must be a power of two.
+    explicit EvalCache(size_t entries = DEFAULT_ENTRIES) : table(entries, 0), mask(entries - 1) {}
+
+    bool probe(uint64_t key, int& score) const {
+        const uint64_t entry = table[key & mask];
+        if ((entry ^ key) >> 16) return false;
+        score = static_cast<int16_t>(entry & 0xFFFF);
+        return true;
+    }
+
+    void store(uint64_t key, int score) {
+        table[key & mask] = (key & ~0xFFFFULL) | static_cast<uint16_t>(score);
+    }
+
+    void clear() { std::fill(table.begin(), table.end(), 0); }
+
+    size_t size_bytes() const { return table.size() * sizeof(uint64_t); }
+
+private:
+    std::vector<uint64_t> table;
+    uint64_t mask;
+};
+
+// evaluate(), answered from 'cache' when the position is in it.
+inline int evaluate(const Position& pos, EvalCache& cache) {
+    STATS_INC(EVAL_CACHE_PROBES);
+    int score;
+    if (cache.probe(pos.hash_key, score)) {
+        STATS_INC(EVAL_CACHE_HITS);
+        return score;
+    }
+    score = evaluate(pos);
+    cache.store(pos.hash_key, score);
+    return score;
+}
+
+} // namespace Eval
+} // namespace aetherchess
@@ -0,0 +1,166 @@
+#pragma once
+
+#include "mapped_file.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace aetherchess {
+
+// On-disk layout of a dataset: this 64-byte header followed by record_count
+// fixed-size records. Each record type names itself with a RECORD_TYPE tag so
+// that a reader cannot misinterpret another kind of file.
+struct DatasetHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_type;
+    uint32_t record_size;
+    uint32_t reserved0;
+    uint64_t record_count;
+    uint8_t reserved[32];
+};
+
+static_assert(sizeof(DatasetHeader) == 64, "DatasetHeader must stay 64 bytes");
+
+constexpr char DATASET_MAGIC[8] = {'A', 'E', 'T', 'H', 'D', 'A', 'T', 'A'};
+constexpr uint32_t DATASET_VERSION = 1;
+
+// Appends records to a dataset file through a write buffer. The record count
+// in the header is patched in by close().
+template <typename Record>
+class DatasetWriter {
+public:
+    ~DatasetWriter() { close(); }
+
+    bool open(const std::string& path) {
+        close();
+        file = std::fopen(path.c_str(), "wb");
+        if (!file) return false;
+        count = 0;
+        buffer.reserve(BUFFER_RECORDS);
+        const DatasetHeader header = make_header();
+        return std::fwrite(&header, sizeof(header), 1, file) == 1;
+    }
+
+    void write(const Record& record) {
+        buffer.push_back(record);
+        if (buffer.size() == BUFFER_RECORDS) flush();
+    }
+
+    // Appends a block of records straight to the file, bypassing the buffer.
+    void write(std::span<const Record> records) {
+        flush();
+        if (std::fwrite(records.data(), sizeof(Record), records.size(), file) != records.size()) failed = true;
+        count += records.size();
+    }
+
+    // Flushes the buffer and finalizes the header. Returns false on I/O errors.
+    bool close() {
+        if (!file) return true;
+        flush();
+        const DatasetHeader header = make_header();
+        bool ok = !failed && std::fseek(file, 0, SEEK_SET) == 0 && std::fwrite(&header, sizeof(header), 1, file) == 1;
+        ok = (std::fclose(file) == 0) && ok;
+        file = nullptr;
+        return ok;
+    }
+
+    uint64_t size() const { return count + buffer.size(); }
+
+private:
+    static constexpr size_t BUFFER_RECORDS = 1 << 15;
+
+    DatasetHeader make_header() const {
+        DatasetHeader header{};
+        std::memcpy(header.magic, DATASET_MAGIC, sizeof(header.magic));
+        header.version = DATASET_VERSION;
+        header.record_type = Record::RECORD_TYPE;
+        header.record_size = sizeof(Record);
+        header.record_count = count;
+        return header;
+    }
+
+    void flush() {
+        if (buffer.empty()) return;
+        if (std::fwrite(buffer.data(), sizeof(Record), buffer.size(), file) != buffer.size()) failed = true;
+        count += buffer.size();
+        buffer.clear();
+    }
+
+    std::FILE* file = nullptr;
+    std::vector<Record> buffer;
+    uint64_t count = 0;
+    bool failed = false;
+};
+
+// Memory-maps a dataset and exposes its records zero-copy, for sequential or
+// random access and for sharded parallel processing.
+template <typename Record>
+class DatasetReader {
+public:
+    // Maps the file and validates its header. 'error' describes any mismatch.
+    bool open(const std::string& path, std::string& error, bool sequential = true) {
+        if (!file.open(path, sequential)) {
+            error = "cannot open " + path;
+            return false;
+        }
+        if (file.size() < sizeof(DatasetHeader)) {
+            error = "file too small for a dataset header";
+            return false;
+        }
+        const auto* header = reinterpret_cast<const DatasetHeader*>(file.data());
+        if (std::memcmp(header->magic, DATASET_MAGIC, sizeof(DATASET_MAGIC)) != 0) {
+            error = "not a dataset file";
+        } else if (header->version != DATASET_VERSION) {
+            error = "unsupported dataset version " + std::to_string(header->version);
+        } else if (header->record_type != Record::RECORD_TYPE || header->record_size != sizeof(Record)) {
+            error = "dataset holds a different record type";
+        } else if (file.size() < sizeof(DatasetHeader) + header->record_count * sizeof(Record)) {
+            error = "dataset is truncated";
+        } else {
+            records_view = {reinterpret_cast<const Record*>(file.data() + sizeof(DatasetHeader)),
+                            static_cast<size_t>(header->record_count)};
+            return true;
+        }
+        file.close();
+        return false;
+    }
+
+    size_t size() const { return records_view.size(); }
+    const Record& operator[](size_t i) const { return records_view[i]; }
+    std::span<const Record> records() const { return records_view; }
+
+    // Returns the index-th of 'shards' contiguous, near-equal slices.
+    std::span<const Record> shard(size_t index, size_t shards) const {
+        const size_t begin = records_view.size() * index / shards;
+        const size_t end = records_view.size() * (index + 1) / shards;
+        return records_view.subspan(begin, end - begin);
+    }
+
+    // Calls f(record, index, thread_id) for every record, with each of
+    // 'threads' threads walking its own shard.
+    template <typename F>
+    void parallel_for_each(int threads, F&& f) const {
+        threads = std::max(1, threads);
+        std::vector<std::thread> pool;
+        for (int t = 0; t < threads; ++t) {
+            pool.emplace_back([this, t, threads, &f]() {
+                const std::span<const Record> slice = shard(t, threads);
+                const size_t base = records_view.size() * t / threads;
+                for (size_t i = 0; i < slice.size(); ++i) f(slice[i], base + i, t);
+            });
+        }
+        for (std::thread& th : pool) th.join();
+    }
+
+private:
+    MappedFile file;
+    std::span<const Record> records_view;
+};
+
+} // namespace aetherchess
@@ -0,0 +1,198 @@
+#include "json.h"
+#include <charconv>
+
+namespace aetherchess {
+namespace Json {
+
+static size_t skip_space(std::string_view text, size_t i) {
+    while (i < text.size() && (text[i] == ' ' || text[i] == '\t' || text[i] == '\n' || text[i] == '\r')) ++i;
+    return i;
+}
+
+// Returns the index just past the string literal starting at text[i] == '"',
+// or npos if it is not terminated.
+static size_t skip_string(std::string_view text, size_t i) {
+    for (++i; i < text.size(); ++i) {
+        if (text[i] == '\\') ++i;
+        else if (text[i] == '"') return i + 1;
+    }
+    return std::string_view::npos;
+}
+
+// Returns the index just past the value starting at text[i], or npos if it is
+// malformed. Nested objects and arrays are only checked for balance.
+static size_t skip_value(std::string_view text, size_t i) {
+    if (i >= text.size()) return std::string_view::npos;
+    if (text[i] == '"') return skip_string(text, i);
+    if (text[i] == '{' || text[i] == '[') {
+        int depth = 0;
+        while (i < text.size()) {
+            const char c = text[i];
+            if (c == '"') {
+                i = skip_string(text, i);
+                if (i == std::string_view::npos) return i;
+                continue;
+            }
+            ++i;
+            if (c == '{' || c == '[') ++depth;
+            else if ((c == '}' || c == ']') && --depth == 0) return i;
+        }
+        return std::string_view::npos;
+    }
+    const size_t begin = i;
+    while (i < text.size() && text[i] != ',' && text[i] != '}' && text[i] != ']' && text[i] != ' ' &&
+           text[i] != '\t' && text[i] != '\n' && text[i] != '\r') {
+        ++i;
+    }
+    return i > begin ? i : std::string_view::npos;
+}
+
+bool Object::parse(std::string_view text, std::string& error) {
+    members.clear();
+    size_t i = skip_space(text, 0);
+    if (i >= text.size() || text[i] != '{') {
+        error = "expected an object";
+        return false;
+    }
+    i = skip_space(text, i + 1);
+    while (i >= text.size() || text[i] != '}') {
+        if (i >= text.size() || text[i] != '"') {
+            error = "expected a member name";
+            return false;
+        }
+        const size_t name_end = skip_string(text, i);
+        std::string name;
+        if (name_end == std::string_view::npos || !decode_string(text.substr(i, name_end - i), name)) {
+            error = "bad member name";
+            return false;
+        }
+        i = skip_space(text, name_end);
+        if (i >= text.size() || text[i] != ':') {
+            error = "expected ':' after \"" + name + "\"";
+            return false;
+        }
+        i = skip_space(text, i + 1);
+        const size_t value_end = skip_value(text, i);
+        if (value_end == std::string_view::npos) {
+            error = "bad value for \"" + name + "\"";
+            return false;
+        }
+        members.emplace_back(std::move(name), text.substr(i, value_end - i));
+        i = skip_space(text, value_end);
+        if (i < text.size() && text[i] == ',') {
+            i = skip_space(text, i + 1);
+        } else if (i >= text.size() || text[i] != '}') {
+            error = "expected ',' or '}'";
+            return false;
+        }
+    }
+    if (skip_space(text, i + 1) != text.size()) {
+        error = "trailing data";
+        return false;
+    }
+    return true;
+}
+
+std::string_view Object::raw(std::string_view key) const {
+    for (const auto& [name, value] : members) {
+        if (name == key) return value;
+    }
+    return {};
+}
+
+bool Object::get(std::string_view key, std::string& value) const {
+    const std::string_view r = raw(key);
+    return !r.empty() && r[0] == '"' && decode_string(r, value);
+}
+
+bool Object::get(std::string_view key, int64_t& value) const {
+    const std::string_view r = raw(key);
+    if (r.empty()) return false;
+    const auto [end, ec] = std::from_chars(r.data(), r.data() + r.size(), value);
+    return ec == std::errc() && end == r.data() + r.size();
+}
+
+bool Object::get(std::string_view key, std::vector<std::string>& values) const {
+    const std::string_view r = raw(key);
+    if (r.empty() || r[0] != '[') return false;
+    values.clear();
+    size_t i = skip_space(r, 1);
+    if (i < r.size() && r[i] == ']') return true;
+    while (i < r.size()) {
+        const size_t end = r[i] == '"' ? skip_string(r, i) : std::string_view::npos;
+        std::string s;
+        if (end == std::string_view::npos || !decode_string(r.substr(i, end - i), s)) return false;
+        values.push_back(std::move(s));
+        i = skip_space(r, end);
+        if (i < r.size() && r[i] == ']') return true;
+        if (i >= r.size() || r[i] != ',') return false;
+        i = skip_space(r, i + 1);
+    }
+    return false;
+}
+
+bool decode_string(std::string_view raw, std::string& out) {
+    if (raw.size() < 2 || raw.front() != '"' || raw.back() != '"') return false;
+    out.clear();
+    for (size_t i = 1; i + 1 < raw.size(); ++i) {
+        char c = raw[i];
+        if (c != '\\') {
+            out += c;
+            continue;
+        }
+        if (++i + 1 >= raw.size()) return false;
+        switch (raw[i]) {
+            case '"': case '\\': case '/': out += raw[i]; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                // Re-encoded as UTF-8. Surrogate pairs are not combined; the
+                // engine only ever needs ASCII out of these strings.
+                unsigned code = 0;
+                if (i + 4 >= raw.size()) return false;
+                const auto [end, ec] = std::from_chars(raw.data() + i + 1, raw.data() + i + 5, code, 16);
+                if (ec != std::errc() || end != raw.data() + i + 5) return false;
+                i += 4;
+                if (code < 0x80) {
+                    out += static_cast<char>(code);
+                } else if (code < 0x800) {
+                    out += static_cast<char>(0xC0 | (code >> 6));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                } else {
+                    out += static_cast<char>(0xE0 | (code >> 12));
+                    out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                }
+                break;
+            }
+            default: return false;
+        }
+    }
+    return true;
+}
+
+std::string quote(std::string_view s) {
+    static constexpr char hex[] = "0123456789abcdef";
+    std::string out = "\"";
+    for (const char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (c == '\n') {
+            out += "\\n";
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out += "\\u00";
+            out += hex[(c >> 4) & 0xF];
+            out += hex[c & 0xF];
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+} // namespace Json
+} // namespace aetherchess
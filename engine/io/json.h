@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace aetherchess {
+namespace Json {
+
+// A single-level JSON object. Member values are kept as raw JSON text
+// (views into the parsed input) and decoded on demand, so nested objects and
+// arrays are carried through without being interpreted.
+class Object {
+public:
+    // Parses text, which must hold exactly one JSON object. Returns false,
+    // with 'error' set, on malformed input.
+    bool parse(std::string_view text, std::string& error);
+
+    // Raw JSON text of a member, or an empty view if it is absent.
+    std::string_view raw(std::string_view key) const;
+    bool has(std::string_view key) const { return !raw(key).empty(); }
+
+    // Typed accessors. They return false if the member is absent or has
+    // another type.
+    bool get(std::string_view key, std::string& value) const;
+    bool get(std::string_view key, int64_t& value) const;
+    bool get(std::string_view key, std::vector<std::string>& values) const;
+
+private:
+    std::vector<std::pair<std::string, std::string_view>> members;
+};
+
+// Decodes a raw JSON string literal (including its quotes).
+bool decode_string(std::string_view raw, std::string& out);
+
+// Encodes s as a JSON string literal.
+std::string quote(std::string_view s);
+
+} // namespace Json
+} // namespace aetherchess
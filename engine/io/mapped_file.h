@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace aetherchess {
+
+// A read-only memory mapping of a whole file. The contents are paged in by the
+// OS on demand, so large inputs can be scanned without copying them.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // Maps the file at path. Returns false if it cannot be opened or mapped.
+    // 'sequential' hints the kernel to read ahead aggressively.
+    bool open(const std::string& path, bool sequential = true);
+    void close();
+
+    bool is_open() const { return data_ != nullptr || (fd_ >= 0 && size_ == 0); }
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    std::string_view view() const { return {data_, size_}; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    int fd_ = -1;
+};
+
+namespace IO {
+
+// Splits the next line off 'rest' and returns it without the line terminator
+// (LF or CRLF). Returns an empty view once 'rest' is exhausted.
+inline std::string_view next_line(std::string_view& rest) {
+    const size_t end = rest.find('\n');
+    std::string_view line = rest.substr(0, end);
+    rest.remove_prefix(end == std::string_view::npos ? rest.size() : end + 1);
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    return line;
+}
+
+} // namespace IO
+} // namespace aetherchess
@@ -0,0 +1,72 @@
+#include "packed_position.h"
+#include <cstring>
+
+namespace aetherchess {
+namespace Packed {
+
+bool encode(const Position& pos, PackedPosition& packed) {
+    std::memset(&packed, 0, sizeof(packed));
+    packed.occupancy = pos.color_bbs[0] | pos.color_bbs[1];
+    if (BB::count_bits(packed.occupancy) > 32) return false;
+    // The move counters have 16 bits; larger ones would silently wrap.
+    if (pos.halfmove_clock > UINT16_MAX || pos.fullmove_number > UINT16_MAX) return false;
+
+    Bitboard occupied = packed.occupancy;
+    for (int i = 0; occupied; ++i) {
+        const Square s = BB::pop_lsb(occupied);
+        const uint8_t code = static_cast<uint8_t>((static_cast<int>(pos.color_on_sq[s]) << 3) |
+                                                  static_cast<int>(pos.piece_on_sq[s]));
+        packed.pieces[i / 2] |= code << ((i & 1) * 4);
+    }
+
+    packed.side_castling = static_cast<uint8_t>((pos.side_to_move == Color::BLACK ? 0x80 : 0) | pos.castling_rights);
+    packed.en_passant_sq = static_cast<uint8_t>(pos.en_passant_sq);
+    packed.halfmove_clock = static_cast<uint16_t>(pos.halfmove_clock);
+    packed.fullmove_number = static_cast<uint16_t>(pos.fullmove_number);
+    return true;
+}
+
+bool decode(const PackedPosition& packed, Position& pos) {
+    for (auto& bbs : pos.piece_bbs) for (Bitboard& bb : bbs) bb = 0ULL;
+    for (Bitboard& bb : pos.color_bbs) bb = 0ULL;
+    for (int s = 0; s < 64; ++s) {
+        pos.piece_on_sq[s] = PieceType::NONE;
+        pos.color_on_sq[s] = Color::NONE;
+    }
+    if (BB::count_bits(packed.occupancy) > 32) return false;
+
+    Bitboard occupied = packed.occupancy;
+    for (int i = 0; occupied; ++i) {
+        const Square s = BB::pop_lsb(occupied);
+        const int code = (packed.pieces[i / 2] >> ((i & 1) * 4)) & 0xF;
+        const int pt = code & 0x7, c = code >> 3;
+        if (pt > static_cast<int>(PieceType::KING)) return false;
+
+        pos.piece_on_sq[s] = static_cast<PieceType>(pt);
+        pos.color_on_sq[s] = static_cast<Color>(c);
+        pos.piece_bbs[c][pt] |= 1ULL << s;
+        pos.color_bbs[c] |= 1ULL << s;
+    }
+
+    // The same placement rules as set_from_fen; the check info below needs
+    // both kings.
+    constexpr Bitboard back_ranks = 0xFF000000000000FFULL;
+    for (int c = 0; c < 2; ++c) {
+        if (BB::count_bits(pos.piece_bbs[c][static_cast<int>(PieceType::KING)]) != 1) return false;
+        if (pos.piece_bbs[c][static_cast<int>(PieceType::PAWN)] & back_ranks) return false;
+    }
+
+    pos.side_to_move = (packed.side_castling & 0x80) ? Color::BLACK : Color::WHITE;
+    if (pos.is_in_check(pos.side_to_move == Color::WHITE ? Color::BLACK : Color::WHITE)) return false;
+    pos.castling_rights = static_cast<CastlingRights>(packed.side_castling & ANY_CASTLING);
+    pos.en_passant_sq = packed.en_passant_sq < 64 ? static_cast<Square>(packed.en_passant_sq) : SQ_NONE;
+    pos.halfmove_clock = packed.halfmove_clock;
+    pos.fullmove_number = packed.fullmove_number;
+    pos.hash_key = pos.calculate_hash();
+    pos.history_ply = 0;
+    pos.set_check_info();
+    return true;
+}
+
+} // namespace Packed
+} // namespace aetherchess
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "../core/position.h"
+#include <cstdint>
+
+namespace aetherchess {
+
+// A fixed-size, lossless 32-byte encoding of a Position, used for binary
+// datasets. The pieces are stored as 4-bit codes (color << 3 | piece type) in
+// ascending square order of the occupancy bitboard, two per byte, low nibble
+// first. A legal position has at most 32 pieces, so 16 bytes suffice.
+struct PackedPosition {
+    static constexpr uint32_t RECORD_TYPE = 1;
+
+    uint64_t occupancy;
+    uint8_t pieces[16];
+    uint8_t side_castling;   // Side to move in bit 7, CastlingRights in bits 0-3.
+    uint8_t en_passant_sq;   // SQ_NONE (64) if there is no en passant square.
+    uint16_t halfmove_clock;
+    uint16_t fullmove_number;
+    uint8_t reserved[2];
+};
+
+static_assert(sizeof(PackedPosition) == 32, "PackedPosition must stay 32 bytes");
+
+namespace Packed {
+
+// Encodes pos. Returns false if it has more than 32 pieces or a move counter
+// above 65535.
+bool encode(const Position& pos, PackedPosition& packed);
+
+// Restores a Position from its encoding, including the hash key and check
+// info. Returns false if the record contains an invalid piece code, a side
+// without exactly one king, a pawn on the first or last rank, or the side not
+// to move in check.
+bool decode(const PackedPosition& packed, Position& pos);
+
+} // namespace Packed
+} // namespace aetherchess
@@ -0,0 +1,215 @@
+#include "pgn.h"
+#include "mapped_file.h"
+#include "../core/san.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace aetherchess {
+namespace PGN {
+
+static constexpr std::string_view START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+static bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+// Characters that end a movetext symbol.
+static bool is_delimiter(char c) {
+    return is_space(c) || c == '{' || c == '}' || c == '(' || c == ')' || c == ';' || c == '[' || c == ']';
+}
+
+static bool parse_result(std::string_view token, GameResult& result) {
+    if (token == "1-0") result = GameResult::WHITE_WINS;
+    else if (token == "0-1") result = GameResult::BLACK_WINS;
+    else if (token == "1/2-1/2") result = GameResult::DRAW;
+    else if (token == "*") result = GameResult::UNKNOWN;
+    else return false;
+    return true;
+}
+
+// Returns the index just past the line containing text[i].
+static size_t skip_line(std::string_view text, size_t i) {
+    const size_t end = text.find('\n', i);
+    return end == std::string_view::npos ? text.size() : end + 1;
+}
+
+// Skips a brace comment starting at text[i] == '{'. Comments do not nest.
+static size_t skip_comment(std::string_view text, size_t i) {
+    const size_t end = text.find('}', i + 1);
+    return end == std::string_view::npos ? text.size() : end + 1;
+}
+
+// Skips a (possibly nested) variation starting at text[i] == '('. Parentheses
+// inside comments do not count.
+static size_t skip_variation(std::string_view text, size_t i) {
+    int depth = 0;
+    while (i < text.size()) {
+        const char c = text[i];
+        if (c == '{') {
+            i = skip_comment(text, i);
+            continue;
+        }
+        if (c == ';') {
+            i = skip_line(text, i);
+            continue;
+        }
+        ++i;
+        if (c == '(') ++depth;
+        else if (c == ')' && --depth == 0) break;
+    }
+    return i;
+}
+
+// Parses a tag pair "[Name "Value"]" starting at text[i] == '['. The value is
+// returned raw, with any backslash escapes left in place.
+static size_t parse_tag(std::string_view text, size_t i, std::string_view& name, std::string_view& value) {
+    size_t j = i + 1;
+    while (j < text.size() && is_space(text[j])) ++j;
+    const size_t name_begin = j;
+    while (j < text.size() && !is_space(text[j]) && text[j] != '"' && text[j] != ']') ++j;
+    name = text.substr(name_begin, j - name_begin);
+    value = {};
+
+    while (j < text.size() && text[j] != '"' && text[j] != ']' && text[j] != '\n') ++j;
+    if (j < text.size() && text[j] == '"') {
+        const size_t value_begin = ++j;
+        while (j < text.size() && text[j] != '"' && text[j] != '\n') j += (text[j] == '\\') ? 2 : 1;
+        j = std::min(j, text.size());
+        value = text.substr(value_begin, j - value_begin);
+    }
+    const size_t end = text.find(']', j);
+    return end == std::string_view::npos ? text.size() : end + 1;
+}
+
+Stats parse_games(std::string_view text, Position& pos, Visitor& visitor) {
+    Stats stats;
+    stats.bytes = text.size();
+
+    bool in_game = false, has_moves = false, ok = true;
+    auto begin_game = [&]() {
+        visitor.begin_game();
+        pos.set_from_fen(START_FEN);
+        in_game = true;
+        has_moves = false;
+        ok = true;
+    };
+    auto end_game = [&](GameResult result) {
+        visitor.end_game(result, ok);
+        ++stats.games;
+        if (!ok) ++stats.errors;
+        in_game = false;
+    };
+
+    size_t i = 0;
+    while (i < text.size()) {
+        const char c = text[i];
+        if (is_space(c)) {
+            ++i;
+        } else if (c == '%' && (i == 0 || text[i - 1] == '\n')) {
+            i = skip_line(text, i); // Escape mechanism: the whole line is ignored.
+        } else if (c == '[') {
+            // A tag after movetext means the previous game had no result token.
+            if (in_game && has_moves) end_game(GameResult::UNKNOWN);
+            if (!in_game) begin_game();
+            std::string_view name, value;
+            i = parse_tag(text, i, name, value);
+            if (name == "FEN" && !pos.set_from_fen(value)) ok = false;
+            visitor.tag(name, value);
+        } else if (c == '{') {
+            i = skip_comment(text, i);
+        } else if (c == ';') {
+            i = skip_line(text, i);
+        } else if (c == '(') {
+            i = skip_variation(text, i);
+        } else if (c == ')' || c == ']' || c == '}') {
+            ++i; // Stray closing bracket.
+        } else {
+            size_t end = i;
+            while (end < text.size() && !is_delimiter(text[end])) ++end;
+            std::string_view token = text.substr(i, end - i);
+            i = end;
+
+            if (!in_game) begin_game();
+            GameResult result;
+            if (parse_result(token, result)) {
+                end_game(result);
+                continue;
+            }
+            if (token[0] == '$') continue; // Numeric annotation glyph
+
+            // Move numbers ("12." or "12...") may be glued to the following move.
+            if (token[0] >= '1' && token[0] <= '9') {
+                token.remove_prefix(std::min(token.find_first_not_of("0123456789"), token.size()));
+            }
+            token.remove_prefix(std::min(token.find_first_not_of('.'), token.size()));
+            if (token.empty() || token.find_first_not_of("!?") == std::string_view::npos) continue;
+
+            has_moves = true;
+            if (!ok) continue;
+
+            const Move m = SAN::to_move(pos, token);
+            if (m == MOVE_NONE) {
+                ok = false;
+                continue;
+            }
+            visitor.move(pos, m);
+            ++stats.positions;
+            pos.make_move(m);
+            // Long games would overrun the state history; only the part that
+            // can still matter for repetitions is kept.
+            if (pos.history_ply >= 200) pos.compact_history();
+        }
+    }
+    if (in_game) end_game(GameResult::UNKNOWN);
+    return stats;
+}
+
+std::vector<std::string_view> split_at_games(std::string_view text, size_t chunk_size) {
+    static constexpr std::string_view marker = "\n[Event ";
+    std::vector<std::string_view> chunks;
+    size_t begin = 0;
+    while (begin < text.size()) {
+        size_t end = text.size();
+        if (text.size() - begin > chunk_size) {
+            const size_t found = text.find(marker, begin + chunk_size);
+            if (found != std::string_view::npos) end = found + 1;
+        }
+        chunks.push_back(text.substr(begin, end - begin));
+        begin = end;
+    }
+    return chunks;
+}
+
+bool replay_file(const std::string& path, int threads,
+                 const std::function<std::unique_ptr<Visitor>(int)>& make_visitor, Stats& stats) {
+    MappedFile file;
+    if (!file.open(path)) return false;
+
+    // Several chunks per thread keep the threads busy to the end even when
+    // game lengths vary across the file.
+    threads = std::max(1, threads);
+    const size_t chunk_size = std::clamp<size_t>(file.size() / (threads * 8), 1 << 20, 64 << 20);
+    const std::vector<std::string_view> chunks = split_at_games(file.view(), chunk_size);
+
+    std::atomic<size_t> next{0};
+    std::vector<Stats> thread_stats(threads);
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t) {
+        pool.emplace_back([&, t]() {
+            auto pos = std::make_unique<Position>();
+            const std::unique_ptr<Visitor> visitor = make_visitor(t);
+            for (size_t i = next++; i < chunks.size(); i = next++) {
+                thread_stats[t] += parse_games(chunks[i], *pos, *visitor);
+            }
+        });
+    }
+    for (std::thread& th : pool) th.join();
+
+    stats = {};
+    for (const Stats& s : thread_stats) stats += s;
+    return true;
+}
+
+} // namespace PGN
+} // namespace aetherchess
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "../core/position.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace aetherchess {
+namespace PGN {
+
+enum class GameResult : uint8_t { WHITE_WINS, BLACK_WINS, DRAW, UNKNOWN };
+
+// Receives the events of a game as the reader replays it. Only the mainline
+// is replayed; variations, comments and NAGs are skipped by the tokenizer.
+class Visitor {
+public:
+    virtual ~Visitor() = default;
+
+    virtual void begin_game() {}
+    virtual void tag(std::string_view /*name*/, std::string_view /*value*/) {}
+    // Called with the position before m is made on it.
+    virtual void move(Position& /*pos*/, Move /*m*/) {}
+    // 'ok' is false if the game was abandoned on an illegal or unparsable move
+    // or an invalid FEN tag; the remaining movetext of that game is skipped.
+    virtual void end_game(GameResult /*result*/, bool /*ok*/) {}
+};
+
+struct Stats {
+    uint64_t games = 0;
+    uint64_t positions = 0;
+    uint64_t errors = 0;
+    uint64_t bytes = 0;
+
+    Stats& operator+=(const Stats& other) {
+        games += other.games;
+        positions += other.positions;
+        errors += other.errors;
+        bytes += other.bytes;
+        return *this;
+    }
+};
+
+// Parses and replays every game in text, which must start at a game boundary.
+// pos is scratch space for the replay.
+Stats parse_games(std::string_view text, Position& pos, Visitor& visitor);
+
+// Splits text into pieces of roughly chunk_size bytes, each starting at a game
+// boundary (an "[Event " tag at the start of a line) so that every piece can
+// be parsed independently.
+std::vector<std::string_view> split_at_games(std::string_view text, size_t chunk_size);
+
+// Memory-maps the file at path and replays it on 'threads' threads, which pull
+// chunks from a shared counter. make_visitor(thread_id) supplies each thread's
+// visitor. Returns false if the file cannot be opened.
+bool replay_file(const std::string& path, int threads,
+                 const std::function<std::unique_ptr<Visitor>(int)>& make_visitor, Stats& stats);
+
+} // namespace PGN
+} // namespace aetherchess
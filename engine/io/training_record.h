@@ -0,0 +1,23 @@
+#pragma once
+
+#include "packed_position.h"
+#include <cstdint>
+
+namespace aetherchess {
+
+// A labeled position for evaluation training: the position, the search score
+// and the final game result, both from the point of view of the side to move.
+struct TrainingRecord {
+    static constexpr uint32_t RECORD_TYPE = 3;
+
+    PackedPosition pos;
+    int16_t score;  // Centipawns.
+    int8_t result;  // 1 win, 0 draw, -1 loss.
+    uint8_t reserved0;
+    uint16_t ply;   // Game ply of the position.
+    uint16_t reserved1;
+};
+
+static_assert(sizeof(TrainingRecord) == 40, "TrainingRecord must stay 40 bytes");
+
+} // namespace aetherchess
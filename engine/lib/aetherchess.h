@@ -0,0 +1,137 @@
+#ifndef AETHERCHESS_H
+#define AETHERCHESS_H
+
+/*
+ * The C interface of libaetherchess, for embedding the engine in another
+ * process. Each aetherchess_engine is an independent engine with its own
+ * position, transposition table and search threads, so a program may run as
+ * many of them at once as it likes. The global tables they share are built on
+ * first use and are read-only afterwards.
+ *
+ * One engine must not be used from two threads at once, except that
+ * aetherchess_stop() may be called from any thread while a search runs.
+ * Functions never throw; failures are reported as aetherchess_status codes.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__GNUC__)
+#define AETHERCHESS_API __attribute__((visibility("default")))
+#else
+#define AETHERCHESS_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Raised whenever a function or struct of this header changes incompatibly. */
+#define AETHERCHESS_API_VERSION 1
+
+typedef enum aetherchess_status {
+    AETHERCHESS_OK = 0,
+    AETHERCHESS_INVALID_ARGUMENT = 1,
+    AETHERCHESS_INVALID_FEN = 2,
+    AETHERCHESS_ILLEGAL_MOVE = 3,
+    AETHERCHESS_OUT_OF_MEMORY = 4,
+    AETHERCHESS_INTERNAL_ERROR = 5
+} aetherchess_status;
+
+typedef struct aetherchess_engine aetherchess_engine;
+
+/* Limits of one search. Zero means "no limit" for every field; with no limit
+ * at all the search runs until aetherchess_stop(). The clock fields work as in
+ * UCI "go wtime ... movestogo". */
+typedef struct aetherchess_limits {
+    int32_t depth;
+    uint64_t nodes;
+    int64_t movetime_ms;
+    int64_t wtime_ms, btime_ms;
+    int64_t winc_ms, binc_ms;
+    int32_t movestogo;
+} aetherchess_limits;
+
+/* A score: 'mate' is the number of moves to mate (negative if the side to move
+ * is mated) and 0 otherwise, in which case 'cp' holds centipawns from the side
+ * to move's point of view. */
+typedef struct aetherchess_score {
+    int32_t cp;
+    int32_t mate;
+} aetherchess_score;
+
+/* Reported after every completed iteration. 'pv' is a space-separated list of
+ * UCI moves, valid only during the callback. */
+typedef struct aetherchess_info {
+    int32_t depth;
+    aetherchess_score score;
+    uint64_t nodes;
+    int64_t time_ms;
+    const char* pv;
+} aetherchess_info;
+
+typedef void (*aetherchess_info_callback)(const aetherchess_info* info, void* user_data);
+
+#define AETHERCHESS_MAX_PV_CHARS 1024
+
+typedef struct aetherchess_result {
+    char best_move[8]; /* UCI move, or "0000" if there is no legal move */
+    aetherchess_score score;
+    int32_t depth;
+    uint64_t nodes;
+    char pv[AETHERCHESS_MAX_PV_CHARS]; /* truncated at a move boundary if longer */
+} aetherchess_result;
+
+/* The AETHERCHESS_API_VERSION the library was built with. */
+AETHERCHESS_API int aetherchess_api_version(void);
+
+AETHERCHESS_API const char* aetherchess_status_string(aetherchess_status status);
+
+/* Creates an engine in the start position with a 'hash_mb' MB transposition
+ * table and 'threads' search threads (both at least 1). Returns NULL if the
+ * memory cannot be allocated. */
+AETHERCHESS_API aetherchess_engine* aetherchess_engine_new(size_t hash_mb, int threads);
+
+/* Stops a running search and frees the engine. NULL is ignored. */
+AETHERCHESS_API void aetherchess_engine_free(aetherchess_engine* engine);
+
+AETHERCHESS_API aetherchess_status aetherchess_set_hash(aetherchess_engine* engine, size_t hash_mb);
+AETHERCHESS_API aetherchess_status aetherchess_set_threads(aetherchess_engine* engine, int threads);
+
+/* Empties the transposition table, as before a new game. */
+AETHERCHESS_API aetherchess_status aetherchess_new_game(aetherchess_engine* engine);
+
+/* Sets the position from a FEN (NULL or "startpos" for the start position)
+ * followed by 'moves', a space-separated list of UCI moves that may be NULL.
+ * On error the position is left unchanged. */
+AETHERCHESS_API aetherchess_status aetherchess_set_position(aetherchess_engine* engine, const char* fen,
+                                                            const char* moves);
+
+/* Writes the FEN of the current position to 'buffer' (128 bytes suffice). */
+AETHERCHESS_API aetherchess_status aetherchess_get_fen(const aetherchess_engine* engine, char* buffer,
+                                                       size_t size);
+
+/* Calls 'callback' with 'user_data' after every iteration of later searches,
+ * on the thread that called aetherchess_search(). NULL turns it off. */
+AETHERCHESS_API aetherchess_status aetherchess_set_info_callback(aetherchess_engine* engine,
+                                                                 aetherchess_info_callback callback,
+                                                                 void* user_data);
+
+/* Searches the current position and blocks until the search ends. 'limits'
+ * may be NULL for an unlimited search. */
+AETHERCHESS_API aetherchess_status aetherchess_search(aetherchess_engine* engine,
+                                                      const aetherchess_limits* limits,
+                                                      aetherchess_result* result);
+
+/* Ends the running search of 'engine' early; safe to call from any thread.
+ * The search still reports its best move so far. */
+AETHERCHESS_API void aetherchess_stop(aetherchess_engine* engine);
+
+/* Counts the leaf nodes of the legal move tree of the current position. */
+AETHERCHESS_API aetherchess_status aetherchess_perft(aetherchess_engine* engine, int depth, uint64_t* nodes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AETHERCHESS_H */
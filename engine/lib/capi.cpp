@@ -0,0 +1,204 @@
+#include "aetherchess.h"
+#include "engine.h"
+#include "../perft.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// The C API is a thin layer over aetherchess::Engine: it converts between the
+// C structs and the engine's types and turns exceptions into status codes.
+
+struct aetherchess_engine {
+    aetherchess::Engine engine;
+    aetherchess_info_callback callback = nullptr;
+    void* user_data = nullptr;
+
+    aetherchess_engine(size_t hash_mb, int threads) : engine(hash_mb, threads) {}
+};
+
+namespace aetherchess {
+namespace {
+
+aetherchess_score to_score(int score) {
+    aetherchess_score s{score, 0};
+    if (std::abs(score) >= Search::VALUE_MATE_IN_MAX_PLY) {
+        const int plies = Search::VALUE_MATE - std::abs(score);
+        s.mate = score > 0 ? (plies + 1) / 2 : -(plies + 1) / 2;
+    }
+    return s;
+}
+
+std::string pv_string(const std::vector<Move>& pv) {
+    std::string s;
+    for (const Move m : pv) {
+        if (!s.empty()) s += ' ';
+        s += Perft::move_to_string(m);
+    }
+    return s;
+}
+
+// Copies 'text' into 'buffer' without splitting a move, always terminated.
+void copy_moves(const std::string& text, char* buffer, size_t size) {
+    size_t length = std::min(text.size(), size - 1);
+    if (length < text.size()) {
+        while (length > 0 && text[length] != ' ') --length;
+    }
+    std::memcpy(buffer, text.data(), length);
+    buffer[length] = '\0';
+}
+
+// Runs 'body', mapping the exceptions the engine can raise to status codes.
+template <typename Body>
+aetherchess_status guarded(Body&& body) {
+    try {
+        return body();
+    } catch (const std::bad_alloc&) {
+        return AETHERCHESS_OUT_OF_MEMORY;
+    } catch (...) {
+        return AETHERCHESS_INTERNAL_ERROR;
+    }
+}
+
+} // namespace
+} // namespace aetherchess
+
+extern "C" {
+
+int aetherchess_api_version(void) {
+    return AETHERCHESS_API_VERSION;
+}
+
+const char* aetherchess_status_string(aetherchess_status status) {
+    switch (status) {
+        case AETHERCHESS_OK: return "ok";
+        case AETHERCHESS_INVALID_ARGUMENT: return "invalid argument";
+        case AETHERCHESS_INVALID_FEN: return "invalid FEN";
+        case AETHERCHESS_ILLEGAL_MOVE: return "illegal move";
+        case AETHERCHESS_OUT_OF_MEMORY: return "out of memory";
+        case AETHERCHESS_INTERNAL_ERROR: return "internal error";
+    }
+    return "unknown status";
+}
+
+aetherchess_engine* aetherchess_engine_new(size_t hash_mb, int threads) {
+    try {
+        return new aetherchess_engine(hash_mb, threads);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void aetherchess_engine_free(aetherchess_engine* engine) {
+    delete engine;
+}
+
+aetherchess_status aetherchess_set_hash(aetherchess_engine* engine, size_t hash_mb) {
+    if (!engine) return AETHERCHESS_INVALID_ARGUMENT;
+    return aetherchess::guarded([&] {
+        engine->engine.set_hash(hash_mb);
+        return AETHERCHESS_OK;
+    });
+}
+
+aetherchess_status aetherchess_set_threads(aetherchess_engine* engine, int threads) {
+    if (!engine || threads < 1) return AETHERCHESS_INVALID_ARGUMENT;
+    return aetherchess::guarded([&] {
+        engine->engine.set_threads(threads);
+        return AETHERCHESS_OK;
+    });
+}
+
+aetherchess_status aetherchess_new_game(aetherchess_engine* engine) {
+    if (!engine) return AETHERCHESS_INVALID_ARGUMENT;
+    engine->engine.new_game();
+    return AETHERCHESS_OK;
+}
+
+aetherchess_status aetherchess_set_position(aetherchess_engine* engine, const char* fen, const char* moves) {
+    if (!engine) return AETHERCHESS_INVALID_ARGUMENT;
+    return aetherchess::guarded([&] {
+        std::vector<std::string> move_list;
+        std::istringstream is(moves ? moves : "");
+        for (std::string token; is >> token;) move_list.push_back(token);
+        std::string error;
+        bool illegal_move = false;
+        if (engine->engine.set_position(fen ? fen : "startpos", move_list, error, illegal_move)) {
+            return AETHERCHESS_OK;
+        }
+        return illegal_move ? AETHERCHESS_ILLEGAL_MOVE : AETHERCHESS_INVALID_FEN;
+    });
+}
+
+aetherchess_status aetherchess_get_fen(const aetherchess_engine* engine, char* buffer, size_t size) {
+    if (!engine || !buffer) return AETHERCHESS_INVALID_ARGUMENT;
+    return aetherchess::guarded([&] {
+        const std::string fen = engine->engine.position().to_fen();
+        if (fen.size() >= size) return AETHERCHESS_INVALID_ARGUMENT;
+        std::memcpy(buffer, fen.c_str(), fen.size() + 1);
+        return AETHERCHESS_OK;
+    });
+}
+
+aetherchess_status aetherchess_set_info_callback(aetherchess_engine* engine,
+                                                 aetherchess_info_callback callback, void* user_data) {
+    if (!engine) return AETHERCHESS_INVALID_ARGUMENT;
+    engine->callback = callback;
+    engine->user_data = user_data;
+    return AETHERCHESS_OK;
+}
+
+aetherchess_status aetherchess_search(aetherchess_engine* engine, const aetherchess_limits* limits,
+                                      aetherchess_result* result) {
+    if (!engine || !result) return AETHERCHESS_INVALID_ARGUMENT;
+    return aetherchess::guarded([&] {
+        aetherchess::Search::Limits search_limits;
+        if (limits) {
+            if (limits->depth > 0) {
+                search_limits.depth = std::min(limits->depth, aetherchess::Search::MAX_PLY - 1);
+            }
+            search_limits.nodes = limits->nodes;
+            search_limits.movetime_ms = limits->movetime_ms;
+            search_limits.wtime_ms = limits->wtime_ms;
+            search_limits.btime_ms = limits->btime_ms;
+            search_limits.winc_ms = limits->winc_ms;
+            search_limits.binc_ms = limits->binc_ms;
+            search_limits.movestogo = limits->movestogo;
+        }
+
+        aetherchess::Search::InfoCallback on_iteration;
+        if (engine->callback) {
+            on_iteration = [engine](const aetherchess::Search::IterationInfo& iteration) {
+                const std::string pv = aetherchess::pv_string(iteration.pv);
+                const aetherchess_info info{iteration.depth, aetherchess::to_score(iteration.score),
+                                            iteration.nodes, iteration.time_ms, pv.c_str()};
+                engine->callback(&info, engine->user_data);
+            };
+        }
+
+        const aetherchess::Search::Result search_result = engine->engine.search(search_limits, on_iteration);
+        const std::string best_move =
+            search_result.best_move ? Perft::move_to_string(search_result.best_move) : "0000";
+        aetherchess::copy_moves(best_move, result->best_move, sizeof(result->best_move));
+        result->score = aetherchess::to_score(search_result.score);
+        result->depth = search_result.depth;
+        result->nodes = search_result.nodes;
+        aetherchess::copy_moves(aetherchess::pv_string(search_result.pv), result->pv, sizeof(result->pv));
+        return AETHERCHESS_OK;
+    });
+}
+
+void aetherchess_stop(aetherchess_engine* engine) {
+    if (engine) engine->engine.stop();
+}
+
+aetherchess_status aetherchess_perft(aetherchess_engine* engine, int depth, uint64_t* nodes) {
+    if (!engine || !nodes || depth < 0) return AETHERCHESS_INVALID_ARGUMENT;
+    *nodes = engine->engine.perft(depth);
+    return AETHERCHESS_OK;
+}
+
+} // extern "C"
@@ -0,0 +1,85 @@
+#include "engine.h"
+#include "../core/init.h"
+#include "../perft.h"
+#include "../uci/uci.h"
+#include <thread>
+
+namespace aetherchess {
+
+static const std::string START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+Engine::Engine(size_t hash_mb, int threads) {
+    init();
+    set_hash(hash_mb);
+    set_threads(threads);
+    pos = std::make_unique<Position>();
+    pos->set_from_fen(START_FEN);
+}
+
+void Engine::set_threads(int threads) {
+    workers.clear();
+    for (int i = 0; i < std::max(1, threads); ++i) workers.push_back(std::make_unique<Search::Worker>(tt));
+}
+
+bool Engine::set_position(std::string_view fen, const std::vector<std::string>& moves, std::string& error,
+                          bool& illegal_move) {
+    auto next = std::make_unique<Position>();
+    illegal_move = false;
+    if (const FenResult result = next->set_from_fen(fen == "startpos" ? START_FEN : fen); !result) {
+        error = "invalid FEN at offset " + std::to_string(result.offset) + ": " +
+                fen_error_string(result.error);
+        return false;
+    }
+    // The history is compacted after each move, as in UCI "position", so that
+    // repetitions stay detectable however long the game is.
+    for (const std::string& token : moves) {
+        const Move m = UCI::to_move(*next, token);
+        if (m == MOVE_NONE) {
+            error = "illegal move " + token;
+            illegal_move = true;
+            return false;
+        }
+        next->make_move(m);
+        next->compact_history();
+    }
+    pos = std::move(next);
+    return true;
+}
+
+Search::Result Engine::search(const Search::Limits& limits, const Search::InfoCallback& on_iteration) {
+    for (auto& worker : workers) worker->stop = false;
+    tt.new_search();
+
+    // Helpers get no clock or node limit of their own; the main worker's
+    // limits end the search for all of them.
+    Search::Limits helper_limits;
+    helper_limits.depth = limits.depth;
+    helper_limits.search_moves = limits.search_moves;
+    std::vector<std::unique_ptr<Position>> helper_positions;
+    std::vector<uint64_t> helper_nodes(workers.size(), 0);
+    std::vector<std::thread> helpers;
+    for (size_t i = 1; i < workers.size(); ++i) {
+        helper_positions.push_back(std::make_unique<Position>(*pos));
+        Position& position = *helper_positions.back();
+        helpers.emplace_back([this, i, &position, &helper_limits, &helper_nodes]() {
+            helper_nodes[i] = workers[i]->search(position, helper_limits).nodes;
+        });
+    }
+
+    Search::Result result = workers[0]->search(*pos, limits, on_iteration);
+
+    for (size_t i = 1; i < workers.size(); ++i) workers[i]->stop = true;
+    for (std::thread& helper : helpers) helper.join();
+    for (const uint64_t nodes : helper_nodes) result.nodes += nodes;
+    return result;
+}
+
+void Engine::stop() {
+    for (auto& worker : workers) worker->stop = true;
+}
+
+uint64_t Engine::perft(int depth) {
+    return Perft::run(*pos, std::max(0, depth));
+}
+
+} // namespace aetherchess
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "../core/position.h"
+#include "../search/search.h"
+#include "../search/tt.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace aetherchess {
+
+// One self-contained engine: a position, a transposition table and a set of
+// search workers. Engines share nothing but the read-only global tables, so
+// any number of them can search at once in one process. This is what the C
+// API in lib/aetherchess.h wraps.
+//
+// Searches are Lazy SMP: the calling thread runs the main worker and the
+// other threads run helpers on copies of the position, all sharing the table.
+// The helpers stop when the main worker does, and its result is returned.
+class Engine {
+public:
+    // Throws std::bad_alloc if the table cannot be allocated.
+    explicit Engine(size_t hash_mb = 16, int threads = 1);
+
+    void set_hash(size_t mb) { tt.resize(std::max<size_t>(1, mb)); }
+    void set_threads(int threads);
+    void new_game() { tt.clear(); }
+
+    // Sets the position from a FEN followed by UCI moves. On failure returns
+    // false with a message in 'error' and keeps the previous position;
+    // 'illegal_move' tells whether the FEN or a move was at fault.
+    bool set_position(std::string_view fen, const std::vector<std::string>& moves, std::string& error,
+                      bool& illegal_move);
+
+    const Position& position() const { return *pos; }
+
+    Search::Result search(const Search::Limits& limits, const Search::InfoCallback& on_iteration = {});
+
+    // Ends a running search early. Safe to call from any thread.
+    void stop();
+
+    uint64_t perft(int depth);
+
+private:
+    TranspositionTable tt;
+    std::vector<std::unique_ptr<Search::Worker>> workers;
+    std::unique_ptr<Position> pos;
+};
+
+} // namespace aetherchess
@@ -0,0 +1,162 @@
+#include "attack_map.h"
+#include "attacks.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define AETHERCHESS_AVX2_ATTACK_MAP
+#include <immintrin.h>
+#endif
+
+namespace aetherchess {
+namespace Attacks {
+
+namespace {
+
+using Bitboards::FILE_A;
+using Bitboards::FILE_B;
+using Bitboards::FILE_G;
+using Bitboards::FILE_H;
+
+Bitboard pawn_attacks_setwise(Bitboard pawns, Color c) {
+    if (c == Color::WHITE) return ((pawns << 9) & ~FILE_A) | ((pawns << 7) & ~FILE_H);
+    return ((pawns >> 7) & ~FILE_A) | ((pawns >> 9) & ~FILE_H);
+}
+
+Bitboard knight_attacks_setwise(Bitboard knights) {
+    const Bitboard l1 = (knights >> 1) & ~FILE_H, l2 = (knights >> 2) & ~(FILE_G | FILE_H);
+    const Bitboard r1 = (knights << 1) & ~FILE_A, r2 = (knights << 2) & ~(FILE_A | FILE_B);
+    const Bitboard h1 = l1 | r1, h2 = l2 | r2;
+    return (h1 << 16) | (h1 >> 16) | (h2 << 8) | (h2 >> 8);
+}
+
+// Fills in the pawn, knight and king maps of both sides; the slider maps are
+// left to the caller.
+void leaper_attacks(const Position& pos, AttackMap& map) {
+    for (int c = 0; c < 2; ++c) {
+        const Bitboard* pieces = pos.piece_bbs[c];
+        map.by_type[c][static_cast<int>(PieceType::PAWN)] =
+            pawn_attacks_setwise(pieces[static_cast<int>(PieceType::PAWN)], static_cast<Color>(c));
+        map.by_type[c][static_cast<int>(PieceType::KNIGHT)] =
+            knight_attacks_setwise(pieces[static_cast<int>(PieceType::KNIGHT)]);
+        const Bitboard king = pieces[static_cast<int>(PieceType::KING)];
+        map.by_type[c][static_cast<int>(PieceType::KING)] = king ? king_attacks[__builtin_ctzll(king)] : 0ULL;
+    }
+}
+
+void combine(AttackMap& map) {
+    for (int c = 0; c < 2; ++c) {
+        map.by_color[c] = 0ULL;
+        for (int pt = 0; pt < 6; ++pt) map.by_color[c] |= map.by_type[c][pt];
+    }
+}
+
+Bitboard slider_attacks_magic(Bitboard pieces, Bitboard occupied, bool bishop) {
+    Bitboard attacks = 0ULL;
+    while (pieces) {
+        const Square s = BB::pop_lsb(pieces);
+        attacks |= bishop ? get_bishop_attacks(s, occupied) : get_rook_attacks(s, occupied);
+    }
+    return attacks;
+}
+
+#ifdef AETHERCHESS_AVX2_ATTACK_MAP
+
+// The sliders of both sides are filled together, one generator per 64-bit
+// lane and one direction per fill, so that every shift is by an immediate
+// and the lanes come out as finished maps without a horizontal reduction.
+template <int Shift>
+__attribute__((target("avx2"))) inline __m256i shift(__m256i x) {
+    if constexpr (Shift > 0) return _mm256_slli_epi64(x, Shift);
+    else return _mm256_srli_epi64(x, -Shift);
+}
+
+// Kogge-Stone occluded fill: the attacks of 'gen' through 'empty' in the
+// direction of Shift. 'mask' drops the squares a step would wrap onto.
+template <int Shift>
+__attribute__((target("avx2"))) inline __m256i fill(__m256i gen, __m256i empty, __m256i mask) {
+    __m256i pro = _mm256_and_si256(empty, mask);
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro, shift<Shift>(gen)));
+    pro = _mm256_and_si256(pro, shift<Shift>(pro));
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro, shift<2 * Shift>(gen)));
+    pro = _mm256_and_si256(pro, shift<2 * Shift>(pro));
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro, shift<4 * Shift>(gen)));
+    return _mm256_and_si256(shift<Shift>(gen), mask);
+}
+
+__attribute__((target("avx2"))) inline __m256i lanes(Bitboard a, Bitboard b, Bitboard c, Bitboard d) {
+    return _mm256_setr_epi64x(static_cast<long long>(a), static_cast<long long>(b), static_cast<long long>(c),
+                              static_cast<long long>(d));
+}
+
+__attribute__((target("avx2"))) void compute_attack_map_avx2(const Position& pos, AttackMap& map) {
+    leaper_attacks(pos, map);
+
+    const Bitboard* white = pos.piece_bbs[static_cast<int>(Color::WHITE)];
+    const Bitboard* black = pos.piece_bbs[static_cast<int>(Color::BLACK)];
+    const int bishop = static_cast<int>(PieceType::BISHOP), rook = static_cast<int>(PieceType::ROOK),
+              queen = static_cast<int>(PieceType::QUEEN);
+    const __m256i straight = lanes(white[rook], white[queen], black[rook], black[queen]);
+    const __m256i diagonal = lanes(white[bishop], white[queen], black[bishop], black[queen]);
+    const __m256i empty = _mm256_set1_epi64x(static_cast<long long>(~(pos.color_bbs[0] | pos.color_bbs[1])));
+    const __m256i all = _mm256_set1_epi64x(-1);
+    const __m256i not_a = _mm256_set1_epi64x(static_cast<long long>(~FILE_A));
+    const __m256i not_h = _mm256_set1_epi64x(static_cast<long long>(~FILE_H));
+
+    const __m256i straight_attacks = _mm256_or_si256(
+        _mm256_or_si256(fill<8>(straight, empty, all), fill<-8>(straight, empty, all)),
+        _mm256_or_si256(fill<1>(straight, empty, not_a), fill<-1>(straight, empty, not_h)));
+    const __m256i diagonal_attacks = _mm256_or_si256(
+        _mm256_or_si256(fill<9>(diagonal, empty, not_a), fill<7>(diagonal, empty, not_h)),
+        _mm256_or_si256(fill<-7>(diagonal, empty, not_a), fill<-9>(diagonal, empty, not_h)));
+
+    alignas(32) Bitboard s[4], d[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(s), straight_attacks);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(d), diagonal_attacks);
+    for (int c = 0; c < 2; ++c) {
+        map.by_type[c][rook] = s[2 * c];
+        map.by_type[c][bishop] = d[2 * c];
+        map.by_type[c][queen] = s[2 * c + 1] | d[2 * c + 1];
+    }
+    combine(map);
+}
+
+#endif
+
+using AttackMapFunction = void (*)(const Position&, AttackMap&);
+
+AttackMapFunction select_implementation() {
+#ifdef AETHERCHESS_AVX2_ATTACK_MAP
+    if (__builtin_cpu_supports("avx2")) return compute_attack_map_avx2;
+#endif
+    return compute_attack_map_magic;
+}
+
+const AttackMapFunction implementation = select_implementation();
+
+} // namespace
+
+void compute_attack_map_magic(const Position& pos, AttackMap& map) {
+    leaper_attacks(pos, map);
+    const Bitboard occupied = pos.color_bbs[0] | pos.color_bbs[1];
+    for (int c = 0; c < 2; ++c) {
+        const Bitboard* pieces = pos.piece_bbs[c];
+        const Bitboard queens = pieces[static_cast<int>(PieceType::QUEEN)];
+        map.by_type[c][static_cast<int>(PieceType::BISHOP)] =
+            slider_attacks_magic(pieces[static_cast<int>(PieceType::BISHOP)], occupied, true);
+        map.by_type[c][static_cast<int>(PieceType::ROOK)] =
+            slider_attacks_magic(pieces[static_cast<int>(PieceType::ROOK)], occupied, false);
+        map.by_type[c][static_cast<int>(PieceType::QUEEN)] =
+            slider_attacks_magic(queens, occupied, true) | slider_attacks_magic(queens, occupied, false);
+    }
+    combine(map);
+}
+
+void compute_attack_map(const Position& pos, AttackMap& map) {
+    implementation(pos, map);
+}
+
+const char* attack_map_implementation() {
+    return implementation == compute_attack_map_magic ? "magic" : "avx2";
+}
+
+} // namespace Attacks
+} // namespace aetherchess
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "../core/position.h"
+
+namespace aetherchess {
+namespace Attacks {
+
+// Every square attacked by each side, by piece type and in total. Sliders
+// are blocked by pieces of both colors, so an attacked own piece is defended.
+struct AttackMap {
+    Bitboard by_type[2][6]; // [Color][PieceType]
+    Bitboard by_color[2];
+};
+
+// Computes the attack maps of both sides in one pass. Pawns, knights and
+// kings are shifted setwise. Sliders use Kogge-Stone occluded fills when the
+// CPU supports AVX2, with the rook, bishop and queen sets of both sides in
+// the lanes of two registers, and one magic lookup per slider otherwise.
+// Both give identical maps.
+void compute_attack_map(const Position& pos, AttackMap& map);
+
+// The magic-lookup implementation, always available.
+void compute_attack_map_magic(const Position& pos, AttackMap& map);
+
+// "avx2" or "magic": the implementation compute_attack_map() uses.
+const char* attack_map_implementation();
+
+} // namespace Attacks
+} // namespace aetherchess
@@ -1,5 +1,9 @@
 #include "attacks.h"
 #include "../bitboard/bitboard.h"
+#include "../core/memory.h"
+#include <algorithm>
+#include <new>
+#include <vector>
 
 namespace aetherchess {
 namespace Attacks {
@@ -8,6 +12,8 @@ namespace Attacks {
 Bitboard pawn_attacks[2][64];
 Bitboard knight_attacks[64];
 Bitboard king_attacks[64];
+Bitboard between_bb[64][64];
+Bitboard line_bb[64][64];
 
 // Helper function to calculate knight attacks for a given square.
 static Bitboard generate_knight_attacks(Square s) {
@@ -60,10 +66,16 @@ static Bitboard generate_pawn_attacks(Square s, Color c) {
 }
 
 // --- Magic Bitboard structures ---
-Magic rook_magics[64];
-Magic bishop_magics[64];
-Bitboard rook_attacks[102400];
-Bitboard bishop_attacks[5248];
+SquareMagics slider_magics[64];
+#ifdef AETHERCHESS_COMPACT_ATTACKS
+const Bitboard* attack_sets;
+const uint8_t* references;
+#else
+const Bitboard* slider_attacks;
+#endif
+
+// The slider tables live in one huge-page-backed block.
+static LargePageBuffer slider_tables;
 
 // --- PRNG for magic number generation ---
 class PRNG {
@@ -126,47 +138,68 @@ static Bitboard generate_sliding_attacks(Square s, Bitboard blockers, bool is_bi
     return attacks;
 }
 
-static void find_magic(Square s, bool is_bishop, PRNG& prng) {
-    static Bitboard* p_rook_attacks = rook_attacks;
-    static Bitboard* p_bishop_attacks = bishop_attacks;
+// Tables under construction, in the compact form; init() expands them for
+// the default layout.
+struct TableBuilder {
+    std::vector<Bitboard> attack_sets;
+    std::vector<uint8_t> references;
+    std::vector<uint16_t> bases; // Per reference, the square's first attack set.
+};
 
-    Magic& magic = is_bishop ? bishop_magics[s] : rook_magics[s];
+// Finds a magic for square s and appends the square's distinct attack sets
+// and its reference table to 'tables'.
+static void find_magic(Square s, bool is_bishop, PRNG& prng, TableBuilder& tables) {
+    Magic& magic = is_bishop ? slider_magics[s].bishop : slider_magics[s].rook;
     magic.mask = is_bishop ? generate_bishop_mask(s) : generate_rook_mask(s);
-    magic.attacks = is_bishop ? p_bishop_attacks : p_rook_attacks;
 
-    int num_mask_bits = BB::count_bits(magic.mask);
-    magic.shift = 64 - num_mask_bits;
-    int num_occupancies = 1 << num_mask_bits;
+    const int num_mask_bits = BB::count_bits(magic.mask);
+    magic.shift = static_cast<uint8_t>(64 - num_mask_bits);
+    const int num_occupancies = 1 << num_mask_bits;
 
+    // The square's distinct attack sets, numbered in order of appearance.
     Bitboard occupancies[4096];
-    Bitboard attacks[4096];
+    uint8_t ids[4096];
+    const size_t base = tables.attack_sets.size();
     Bitboard b = 0ULL;
-    for(int i=0; i < num_occupancies; ++i) {
+    for (int i = 0; i < num_occupancies; ++i) {
         occupancies[i] = b;
-        attacks[i] = generate_sliding_attacks(s, b, is_bishop);
+        const Bitboard attacks = generate_sliding_attacks(s, b, is_bishop);
+        size_t id = base;
+        while (id < tables.attack_sets.size() && tables.attack_sets[id] != attacks) ++id;
+        if (id == tables.attack_sets.size()) tables.attack_sets.push_back(attacks);
+        ids[i] = static_cast<uint8_t>(id - base);
         b = (b - magic.mask) & magic.mask;
     }
+#ifdef AETHERCHESS_COMPACT_ATTACKS
+    magic.base = static_cast<uint16_t>(base);
+#endif
 
-    for (int i = 0; i < 100000000; i++) {
+    // A magic is valid if colliding occupancies share their attack set. The
+    // epoch stamps spare clearing the scratch table after every failed try.
+    uint8_t scratch[4096];
+    int epoch_of[4096] = {};
+    for (int epoch = 1; epoch < 100000000; ++epoch) {
         magic.magic = prng.next_sparse();
         if (BB::count_bits((magic.mask * magic.magic) & 0xFF00000000000000ULL) < 6) continue;
 
         bool fail = false;
-        for (int j = 0; j < num_occupancies; j++) {
-            int idx = (occupancies[j] * magic.magic) >> magic.shift;
-            if (magic.attacks[idx] == 0ULL) {
-                magic.attacks[idx] = attacks[j];
-            } else if (magic.attacks[idx] != attacks[j]) {
-                fail = true;
-                for(int k=0; k<j; ++k) magic.attacks[(occupancies[k] * magic.magic) >> magic.shift] = 0ULL;
-                break;
+        for (int j = 0; j < num_occupancies && !fail; ++j) {
+            const int idx = static_cast<int>((occupancies[j] * magic.magic) >> magic.shift);
+            if (epoch_of[idx] != epoch) {
+                epoch_of[idx] = epoch;
+                scratch[idx] = ids[j];
+            } else {
+                fail = scratch[idx] != ids[j];
             }
         }
-        if (!fail) {
-             if (is_bishop) p_bishop_attacks += num_occupancies;
-             else p_rook_attacks += num_occupancies;
-             return;
+        if (fail) continue;
+
+        magic.offset = static_cast<uint32_t>(tables.references.size());
+        for (int idx = 0; idx < num_occupancies; ++idx) {
+            tables.references.push_back(epoch_of[idx] == epoch ? scratch[idx] : 0);
         }
+        tables.bases.insert(tables.bases.end(), num_occupancies, static_cast<uint16_t>(base));
+        return;
     }
     // This is a fatal error, the engine cannot run without magic numbers.
 }
@@ -183,10 +216,52 @@ void init() {
 
     // 2. Initialize sliding piece attacks using magic bitboards
     PRNG prng(1070372);
+    TableBuilder tables;
     for (int sq = 0; sq < 64; ++sq) {
-        find_magic(static_cast<Square>(sq), false, prng); // Rooks
-        find_magic(static_cast<Square>(sq), true, prng);  // Bishops
+        find_magic(static_cast<Square>(sq), false, prng, tables); // Rooks
+        find_magic(static_cast<Square>(sq), true, prng, tables);  // Bishops
+    }
+
+#ifdef AETHERCHESS_COMPACT_ATTACKS
+    const size_t sets_bytes = tables.attack_sets.size() * sizeof(Bitboard);
+    if (!slider_tables.allocate(sets_bytes + tables.references.size())) throw std::bad_alloc();
+    Bitboard* const sets = static_cast<Bitboard*>(slider_tables.data());
+    uint8_t* const refs = static_cast<uint8_t*>(slider_tables.data()) + sets_bytes;
+    std::copy(tables.attack_sets.begin(), tables.attack_sets.end(), sets);
+    std::copy(tables.references.begin(), tables.references.end(), refs);
+    attack_sets = sets;
+    references = refs;
+#else
+    if (!slider_tables.allocate(tables.references.size() * sizeof(Bitboard))) throw std::bad_alloc();
+    Bitboard* const table = static_cast<Bitboard*>(slider_tables.data());
+    for (size_t i = 0; i < tables.references.size(); ++i) {
+        table[i] = tables.attack_sets[tables.bases[i] + tables.references[i]];
     }
+    slider_attacks = table;
+#endif
+
+    // 3. Initialize line and between tables from the slider attacks
+    for (int s1 = 0; s1 < 64; ++s1) {
+        for (int s2 = 0; s2 < 64; ++s2) {
+            const Square a = static_cast<Square>(s1), b = static_cast<Square>(s2);
+            const Bitboard b_bb = 1ULL << s2;
+            between_bb[s1][s2] = b_bb;
+            line_bb[s1][s2] = 0ULL;
+            if (s1 == s2) continue;
+
+            if (get_rook_attacks(a, 0ULL) & b_bb) {
+                line_bb[s1][s2] = (get_rook_attacks(a, 0ULL) & get_rook_attacks(b, 0ULL)) | (1ULL << s1) | b_bb;
+                between_bb[s1][s2] |= get_rook_attacks(a, b_bb) & get_rook_attacks(b, 1ULL << s1);
+            } else if (get_bishop_attacks(a, 0ULL) & b_bb) {
+                line_bb[s1][s2] = (get_bishop_attacks(a, 0ULL) & get_bishop_attacks(b, 0ULL)) | (1ULL << s1) | b_bb;
+                between_bb[s1][s2] |= get_bishop_attacks(a, b_bb) & get_bishop_attacks(b, 1ULL << s1);
+            }
+        }
+    }
+}
+
+std::string memory_info() {
+    return slider_tables.describe();
 }
 
 } // namespace Attacks
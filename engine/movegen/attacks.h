@@ -2,6 +2,7 @@
 
 #include "../core/types.h"
 #include "../bitboard/bitboard.h"
+#include <string>
 
 namespace aetherchess {
 namespace Attacks {
@@ -11,41 +12,99 @@ extern Bitboard pawn_attacks[2][64];
 extern Bitboard knight_attacks[64];
 extern Bitboard king_attacks[64];
 
+// Squares strictly between two squares on a common rank, file or diagonal,
+// plus the second square itself. Only the second square if they are not aligned.
+// Indexed by [from][to].
+extern Bitboard between_bb[64][64];
+
+// The full board-edge to board-edge line through two aligned squares, or empty.
+// Indexed by [Square][Square].
+extern Bitboard line_bb[64][64];
+
 // --- Magic Bitboards for Sliding Pieces ---
 
+// By default every magic index selects a full attack bitboard in one table
+// of 107648 entries (841 KB). With AETHERCHESS_COMPACT_ATTACKS the tables
+// are two-level instead: a rook has at most 144 distinct attack sets on a
+// square (a bishop fewer), so the index selects a one-byte reference to one
+// of them, and each attack set is stored once. That is 155 KB in all, small
+// enough to stay in a 256-512 KB L2 next to the search, at the price of a
+// second dependent load per lookup. On CPUs whose L2 holds the full table
+// the default is faster.
+
 // The Magic struct holds the data needed for magic bitboard lookups for a single square.
 struct Magic {
-    Bitboard* attacks; // Pointer to the start of the attack table for this square
     Bitboard mask;     // Mask of relevant blocker squares
     Bitboard magic;    // The magic number used for hashing
-    int shift;         // Shift to apply after multiplication to get the index
+    uint32_t offset;   // Start of the square's slots in the attack or reference table
+#ifdef AETHERCHESS_COMPACT_ATTACKS
+    uint16_t base;     // Index of the square's first attack set in 'attack_sets'
+#endif
+    uint8_t shift;     // Shift to apply after multiplication to get the index
 };
 
-extern Magic rook_magics[64];
-extern Magic bishop_magics[64];
+// The rook and bishop magics of a square share a cache line, so a queen
+// lookup touches a single line of magics.
+struct alignas(64) SquareMagics {
+    Magic rook;
+    Magic bishop;
+};
+
+extern SquareMagics slider_magics[64];
+#ifdef AETHERCHESS_COMPACT_ATTACKS
+extern const Bitboard* attack_sets;
+extern const uint8_t* references;
+#else
+extern const Bitboard* slider_attacks;
+#endif
 
 // Initializes all attack tables, including magic bitboards.
-// Must be called once at program startup.
+// Called once, through aetherchess::init() (core/init.h).
 void init();
 
+// Size and huge page backing of the slider attack tables, for "info string".
+std::string memory_info();
+
 // Inline functions to get sliding piece attacks using the generated tables.
+inline Bitboard magic_attacks(const Magic& m, Bitboard occupied) {
+    occupied &= m.mask;
+    occupied *= m.magic;
+    occupied >>= m.shift;
+#ifdef AETHERCHESS_COMPACT_ATTACKS
+    return attack_sets[m.base + references[m.offset + occupied]];
+#else
+    return slider_attacks[m.offset + occupied];
+#endif
+}
+
 inline Bitboard get_rook_attacks(Square s, Bitboard occupied) {
-    occupied &= rook_magics[s].mask;
-    occupied *= rook_magics[s].magic;
-    occupied >>= rook_magics[s].shift;
-    return rook_magics[s].attacks[occupied];
+    return magic_attacks(slider_magics[s].rook, occupied);
 }
 
 inline Bitboard get_bishop_attacks(Square s, Bitboard occupied) {
-    occupied &= bishop_magics[s].mask;
-    occupied *= bishop_magics[s].magic;
-    occupied >>= bishop_magics[s].shift;
-    return bishop_magics[s].attacks[occupied];
+    return magic_attacks(slider_magics[s].bishop, occupied);
 }
 
 inline Bitboard get_queen_attacks(Square s, Bitboard occupied) {
     return get_rook_attacks(s, occupied) | get_bishop_attacks(s, occupied);
 }
 
+// Attacks of a non-pawn piece type from square s.
+inline Bitboard get_piece_attacks(PieceType pt, Square s, Bitboard occupied) {
+    switch (pt) {
+        case PieceType::KNIGHT: return knight_attacks[s];
+        case PieceType::BISHOP: return get_bishop_attacks(s, occupied);
+        case PieceType::ROOK:   return get_rook_attacks(s, occupied);
+        case PieceType::QUEEN:  return get_queen_attacks(s, occupied);
+        case PieceType::KING:   return king_attacks[s];
+        default:                return 0ULL;
+    }
+}
+
+// Returns true if the three squares lie on a common rank, file or diagonal.
+inline bool aligned(Square s1, Square s2, Square s3) {
+    return line_bb[s1][s2] & (1ULL << s3);
+}
+
 } // namespace Attacks
 } // namespace aetherchess
@@ -1,21 +1,28 @@
 #include "movegen.h"
 #include "../core/position.h"
+#include "../core/stats.h"
 #include "attacks.h"
-#include <iostream>
 
 namespace aetherchess {
 namespace MoveGenerator {
 
 // Forward declarations for static helper functions
-static void generate_pawn_moves(const Position& pos, MoveList& move_list);
-static void generate_knight_moves(const Position& pos, MoveList& move_list);
-static void generate_king_moves(const Position& pos, MoveList& move_list);
-static void generate_rook_moves(const Position& pos, MoveList& move_list);
-static void generate_bishop_moves(const Position& pos, MoveList& move_list);
-static void generate_queen_moves(const Position& pos, MoveList& move_list);
+template <typename List>
+static void generate_pawn_moves(const Position& pos, List& move_list);
+template <typename List>
+static void generate_knight_moves(const Position& pos, List& move_list);
+template <typename List>
+static void generate_king_moves(const Position& pos, List& move_list);
+template <typename List>
+static void generate_rook_moves(const Position& pos, List& move_list);
+template <typename List>
+static void generate_bishop_moves(const Position& pos, List& move_list);
+template <typename List>
+static void generate_queen_moves(const Position& pos, List& move_list);
 
-// Main function to generate all pseudo-legal moves in a position.
-void generate_moves(const Position& pos, MoveList& move_list) {
+// Generates all pseudo-legal moves into either list type.
+template <typename List>
+static void generate_all(const Position& pos, List& move_list) {
     generate_pawn_moves(pos, move_list);
     generate_knight_moves(pos, move_list);
     generate_king_moves(pos, move_list);
@@ -24,9 +31,25 @@ void generate_moves(const Position& pos, MoveList& move_list) {
     generate_queen_moves(pos, move_list);
 }
 
+// Main function to generate all pseudo-legal moves in a position.
+void generate_moves(const Position& pos, MoveList& move_list) {
+    STATS_TIMER(PHASE_MOVEGEN);
+    generate_all(pos, move_list);
+    STATS_INC(GENERATE_CALLS);
+    STATS_ADD(GENERATED_MOVES, move_list.count);
+}
+
+void generate_moves(const Position& pos, ScoredMoveList& move_list) {
+    STATS_TIMER(PHASE_MOVEGEN);
+    generate_all(pos, move_list);
+    STATS_INC(GENERATE_CALLS);
+    STATS_ADD(GENERATED_MOVES, move_list.count);
+}
+
 // --- Sliding Piece Move Generation ---
 
-static void generate_rook_moves(const Position& pos, MoveList& move_list) {
+template <typename List>
+static void generate_rook_moves(const Position& pos, List& move_list) {
     const int us = static_cast<int>(pos.side_to_move);
     Bitboard rooks = pos.piece_bbs[us][static_cast<int>(PieceType::ROOK)];
     const Bitboard occupied = pos.color_bbs[0] | pos.color_bbs[1];
@@ -48,7 +71,8 @@ static void generate_rook_moves(const Position& pos, MoveList& move_list) {
     }
 }
 
-static void generate_bishop_moves(const Position& pos, MoveList& move_list) {
+template <typename List>
+static void generate_bishop_moves(const Position& pos, List& move_list) {
     const int us = static_cast<int>(pos.side_to_move);
     Bitboard bishops = pos.piece_bbs[us][static_cast<int>(PieceType::BISHOP)];
     const Bitboard occupied = pos.color_bbs[0] | pos.color_bbs[1];
@@ -70,7 +94,8 @@ static void generate_bishop_moves(const Position& pos, MoveList& move_list) {
     }
 }
 
-static void generate_queen_moves(const Position& pos, MoveList& move_list) {
+template <typename List>
+static void generate_queen_moves(const Position& pos, List& move_list) {
     const int us = static_cast<int>(pos.side_to_move);
     Bitboard queens = pos.piece_bbs[us][static_cast<int>(PieceType::QUEEN)];
     const Bitboard occupied = pos.color_bbs[0] | pos.color_bbs[1];
@@ -93,7 +118,8 @@ static void generate_queen_moves(const Position& pos, MoveList& move_list) {
 }
 
 // Helper function to generate knight moves.
-static void generate_knight_moves(const Position& pos, MoveList& move_list) {
+template <typename List>
+static void generate_knight_moves(const Position& pos, List& move_list) {
     const int us = static_cast<int>(pos.side_to_move);
     Bitboard knights = pos.piece_bbs[us][static_cast<int>(PieceType::KNIGHT)];
     const Bitboard their_pieces = pos.color_bbs[1 - us];
@@ -117,7 +143,8 @@ static void generate_knight_moves(const Position& pos, MoveList& move_list) {
 }
 
 // Helper function to generate king moves.
-static void generate_king_moves(const Position& pos, MoveList& move_list) {
+template <typename List>
+static void generate_king_moves(const Position& pos, List& move_list) {
     const int us = static_cast<int>(pos.side_to_move);
     const Bitboard occupied = pos.color_bbs[0] | pos.color_bbs[1];
 
@@ -127,7 +154,7 @@ static void generate_king_moves(const Position& pos, MoveList& move_list) {
 
     Square from_sq = BB::pop_lsb(king_bb);
     Bitboard attacks = Attacks::king_attacks[from_sq];
-    Bitboard quiet_moves = attacks & ~pos.color_bbs[us];
+    Bitboard quiet_moves = attacks & ~occupied;
     Bitboard capture_moves = attacks & pos.color_bbs[1 - us];
 
     while (quiet_moves) {
@@ -139,26 +166,26 @@ static void generate_king_moves(const Position& pos, MoveList& move_list) {
         move_list.add(Moves::create(from_sq, to_sq, CAPTURE));
     }
 
-    // Castling
-    if (!pos.is_in_check(static_cast<Color>(us))) {
+    // Castling. The king may not castle out of check; the checkers are cached.
+    if (!pos.checkers()) {
         if (us == static_cast<int>(Color::WHITE)) {
-            if ((pos.castling_rights & WHITE_KINGSIDE) && !(occupied & 0x6000000000000000ULL)) {
+            if ((pos.castling_rights & WHITE_KINGSIDE) && !(occupied & 0x60ULL)) {
                 if (!pos.is_square_attacked(F1, Color::BLACK)) {
                     move_list.add(Moves::create(E1, G1, KING_CASTLE));
                 }
             }
-            if ((pos.castling_rights & WHITE_QUEENSIDE) && !(occupied & 0xE00000000000000ULL)) {
+            if ((pos.castling_rights & WHITE_QUEENSIDE) && !(occupied & 0xEULL)) {
                 if (!pos.is_square_attacked(D1, Color::BLACK)) {
                     move_list.add(Moves::create(E1, C1, QUEEN_CASTLE));
                 }
             }
         } else { // BLACK
-            if ((pos.castling_rights & BLACK_KINGSIDE) && !(occupied & 0x60ULL)) {
+            if ((pos.castling_rights & BLACK_KINGSIDE) && !(occupied & 0x6000000000000000ULL)) {
                 if (!pos.is_square_attacked(F8, Color::WHITE)) {
                     move_list.add(Moves::create(E8, G8, KING_CASTLE));
                 }
             }
-            if ((pos.castling_rights & BLACK_QUEENSIDE) && !(occupied & 0xEULL)) {
+            if ((pos.castling_rights & BLACK_QUEENSIDE) && !(occupied & 0xE00000000000000ULL)) {
                 if (!pos.is_square_attacked(D8, Color::WHITE)) {
                     move_list.add(Moves::create(E8, C8, QUEEN_CASTLE));
                 }
@@ -168,7 +195,8 @@ static void generate_king_moves(const Position& pos, MoveList& move_list) {
 }
 
 // Helper function to generate pawn moves.
-static void generate_pawn_moves(const Position& pos, MoveList& move_list) {
+template <typename List>
+static void generate_pawn_moves(const Position& pos, List& move_list) {
     const int us = static_cast<int>(pos.side_to_move);
     const int them = 1 - us;
     const Bitboard their_pieces = pos.color_bbs[them];
@@ -179,8 +207,8 @@ static void generate_pawn_moves(const Position& pos, MoveList& move_list) {
     if (us == static_cast<int>(Color::WHITE)) {
         Bitboard single_pushes = (pawns << 8) & ~occupied;
         Bitboard double_pushes = ((single_pushes & Bitboards::RANK_3) << 8) & ~occupied;
-        Bitboard left_captures = ((pawns & ~Bitboards::FILE_A) << 9) & their_pieces;
-        Bitboard right_captures = ((pawns & ~Bitboards::FILE_H) << 7) & their_pieces;
+        Bitboard left_captures = ((pawns & ~Bitboards::FILE_H) << 9) & their_pieces;
+        Bitboard right_captures = ((pawns & ~Bitboards::FILE_A) << 7) & their_pieces;
 
         Bitboard promo_rank = Bitboards::RANK_8;
 
@@ -225,9 +253,7 @@ static void generate_pawn_moves(const Position& pos, MoveList& move_list) {
             }
         }
         if (pos.en_passant_sq != SQ_NONE) {
-            std::cout << "DEBUG: White EP check, square is " << pos.en_passant_sq << std::endl;
             Bitboard ep_attacks = Attacks::pawn_attacks[them][pos.en_passant_sq] & pawns;
-            if (ep_attacks) std::cout << "DEBUG: White found potential EP attacker!" << std::endl;
             while(ep_attacks) {
                 Square from_sq = BB::pop_lsb(ep_attacks);
                 move_list.add(Moves::create(from_sq, pos.en_passant_sq, EN_PASSANT));
@@ -6,28 +6,51 @@
 
 namespace aetherchess {
 
+// The maximum number of legal moves from any chess position.
+constexpr int MAX_MOVES = 218;
+
 // A container for generated moves.
 // To avoid performance overhead from dynamic memory allocation during the search,
-// this list uses a fixed-size array. The maximum number of legal moves from any
-// chess position is 218, so 256 is a safe upper bound.
+// this list uses a fixed-size array sized to the true maximum move count.
 struct MoveList {
-    std::array<Move, 256> moves;
+    std::array<Move, MAX_MOVES> moves;
     int count = 0;
 
     // Adds a move to the list.
     void add(Move m) {
-        if (count < 256) {
+        if (count < MAX_MOVES) {
             moves[count++] = m;
         }
     }
 };
 
+// A move with an ordering score attached, used by move pickers.
+struct ExtMove {
+    Move move;
+    int16_t score;
+};
+
+// A move list that carries a score per move for ordering. Kept separate from
+// MoveList so that perft and legality loops do not pay for the scores.
+struct ScoredMoveList {
+    std::array<ExtMove, MAX_MOVES> moves;
+    int count = 0;
+
+    // Adds a move to the list with a zero score.
+    void add(Move m) {
+        if (count < MAX_MOVES) {
+            moves[count++] = {m, 0};
+        }
+    }
+};
+
 // The MoveGenerator namespace contains functions for generating moves.
 namespace MoveGenerator {
 
 // Generates all pseudo-legal moves for the given position and adds them
 // to the provided MoveList.
 void generate_moves(const Position& pos, MoveList& move_list);
+void generate_moves(const Position& pos, ScoredMoveList& move_list);
 
 // (Future work: Private helper functions for generating moves for each piece type)
 // void generate_pawn_moves(const Position& pos, MoveList& move_list);
@@ -0,0 +1,277 @@
+#include "mate.h"
+#include "../movegen/movegen.h"
+#include <algorithm>
+#include <chrono>
+#include <new>
+
+namespace aetherchess {
+namespace Mate {
+
+namespace {
+
+int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Sums saturate below INFINITE, so a large but finite number never reads as
+// a solved node.
+uint32_t add(uint32_t a, uint32_t b) {
+    if (a == INFINITE || b == INFINITE) return INFINITE;
+    return std::min(a + b, INFINITE - 1);
+}
+
+// pn and dn are never both zero, so an all-zero entry is unused.
+bool is_empty(const ProofEntry& e) {
+    return e.pn_depth == 0 && e.dn_length == 0;
+}
+
+constexpr Numbers PROVEN = {0, INFINITE, 0};
+constexpr Numbers DISPROVEN = {INFINITE, 0, 0};
+
+// The moves searched at a node: checks for the attacker, every legal move for
+// the defender.
+int expand(const Position& pos, bool attacker, Move* children) {
+    MoveList list;
+    MoveGenerator::generate_moves(pos, list);
+    int count = 0;
+    for (int i = 0; i < list.count; ++i) {
+        const Move m = list.moves[i];
+        if (!pos.is_legal(m)) continue;
+        if (attacker && !pos.gives_check(m)) continue;
+        children[count++] = m;
+    }
+    return count;
+}
+
+int count_legal_moves(const Position& pos) {
+    MoveList list;
+    MoveGenerator::generate_moves(pos, list);
+    int count = 0;
+    for (int i = 0; i < list.count; ++i) count += pos.is_legal(list.moves[i]);
+    return count;
+}
+
+} // namespace
+
+void ProofTable::resize(size_t mb) {
+    const size_t count = std::max<size_t>(1, mb * 1024 * 1024 / sizeof(ProofCluster));
+    release();
+    if (!memory.allocate(count * sizeof(ProofCluster))) throw std::bad_alloc();
+    clusters = static_cast<ProofCluster*>(memory.data());
+    cluster_count = count;
+}
+
+void ProofTable::release() {
+    memory.release();
+    clusters = nullptr;
+    cluster_count = 0;
+}
+
+bool ProofTable::probe(uint64_t key, int depth, Numbers& numbers) const {
+    bool found = false;
+    for (const ProofEntry& e : cluster(key).entries) {
+        if (e.key != key || is_empty(e)) continue;
+        if (e.pn() == 0 && e.length() <= depth) {
+            numbers = {0, INFINITE, e.length()};
+            return true;
+        }
+        if (e.dn() == 0 && e.depth() >= depth) {
+            numbers = DISPROVEN;
+            return true;
+        }
+        if (e.depth() == depth) {
+            numbers = {e.pn(), e.dn(), 0};
+            found = true;
+        }
+    }
+    return found;
+}
+
+void ProofTable::store(uint64_t key, int depth, const Numbers& numbers) {
+    ProofEntry* const entries = cluster(key).entries;
+    ProofEntry* replace = nullptr;
+    for (int i = 0; i < 4 && !replace; ++i) {
+        const ProofEntry& e = entries[i];
+        if (e.key == key && e.depth() == depth && !is_empty(e)) replace = &entries[i];
+    }
+    for (int i = 0; i < 4 && !replace; ++i) {
+        if (is_empty(entries[i])) replace = &entries[i];
+    }
+    if (!replace) {
+        replace = &entries[0];
+        for (int i = 1; i < 4; ++i) {
+            if (entries[i].depth() < replace->depth()) replace = &entries[i];
+        }
+    }
+    replace->key = key;
+    replace->pn_depth = numbers.pn | static_cast<uint32_t>(depth) << 24;
+    replace->dn_length = numbers.dn | static_cast<uint32_t>(numbers.length) << 24;
+}
+
+void Solver::check_limits() {
+    if (limits.nodes && nodes >= limits.nodes) stop = true;
+    if (limits.movetime_ms && now_ms() - start_time_ms >= limits.movetime_ms) stop = true;
+}
+
+// One df-pn call: expands the node until its numbers reach a threshold, then
+// stores and returns them. phi and delta are the node's numbers from the side to move's
+// point of view (pn and dn at attacker nodes, dn and pn at defender nodes), so
+// both node types share the same minimum/sum rules. 'depth' is the number of
+// plies left for the attacker to mate in.
+Numbers Solver::search(Position& pos, int depth, uint32_t th_phi, uint32_t th_delta) {
+    if (++nodes % CHECK_INTERVAL == 0) check_limits();
+
+    const bool at_attacker = pos.side_to_move == attacker;
+    Move children[MAX_MOVES];
+    uint64_t keys[MAX_MOVES];
+    // The children's numbers are also kept here, so that the search still
+    // progresses when their entries are replaced in a crowded table.
+    Numbers numbers[MAX_MOVES];
+    const int count = expand(pos, at_attacker, children);
+
+    // Leaves. The attacker loses without a check or plies to give it in; the
+    // defender is mated without a legal move in check, and escapes by
+    // stalemate or by running the attacker out of plies.
+    if (count == 0 || depth <= 0) {
+        const bool mated = !at_attacker && count == 0 && pos.checkers();
+        table.store(pos.hash_key, depth, mated ? PROVEN : DISPROVEN);
+        return mated ? PROVEN : DISPROVEN;
+    }
+
+    // First visit: every check is scored by the defender's number of legal
+    // replies, so positions with few escapes are tried first, and mates in
+    // one are found without a visit of their own.
+    for (int i = 0; i < count; ++i) {
+        keys[i] = pos.key_after(children[i]);
+        if (!at_attacker || table.probe(keys[i], depth - 1, numbers[i])) continue;
+        pos.make_move(children[i]);
+        const int replies = count_legal_moves(pos);
+        pos.unmake_move(children[i]);
+        if (replies == 0) numbers[i] = PROVEN;
+        else if (depth - 1 == 0) numbers[i] = DISPROVEN;
+        else numbers[i] = {static_cast<uint32_t>(replies), 1, 0};
+        table.store(keys[i], depth - 1, numbers[i]);
+    }
+
+    while (true) {
+        // phi is the least delta of a child, delta the sum of the children's
+        // phi. The child with the least delta is searched next.
+        uint32_t phi = INFINITE, delta = 0, second = INFINITE, best_child_phi = 0;
+        int best = 0, best_length = at_attacker ? 255 : 0;
+        for (int i = 0; i < count; ++i) {
+            table.probe(keys[i], depth - 1, numbers[i]);
+            const Numbers& child = numbers[i];
+            // The child's side to move is the other side.
+            const uint32_t child_phi = at_attacker ? child.dn : child.pn;
+            const uint32_t child_delta = at_attacker ? child.pn : child.dn;
+            delta = add(delta, child_phi);
+            if (child_delta < phi) {
+                second = phi;
+                phi = child_delta;
+                best = i;
+                best_child_phi = child_phi;
+            } else if (child_delta < second) {
+                second = child_delta;
+            }
+            if (child.pn == 0 && at_attacker) best_length = std::min(best_length, child.length);
+            if (child.pn == 0 && !at_attacker) best_length = std::max(best_length, child.length);
+        }
+
+        if (phi >= th_phi || delta >= th_delta || stop) {
+            Numbers node = at_attacker ? Numbers{phi, delta, 0} : Numbers{delta, phi, 0};
+            if (node.pn == 0) node.length = best_length + 1;
+            table.store(pos.hash_key, depth, node);
+            return node;
+        }
+
+        // The child may use the node's delta slack and must stay below the
+        // second-best child's delta; the 1 + 1/4 margin keeps the search from
+        // switching back and forth between two close siblings.
+        const uint32_t child_th_phi =
+            static_cast<uint32_t>(std::min<uint64_t>(INFINITE, uint64_t{th_delta} - delta + best_child_phi));
+        const uint32_t child_th_delta =
+            static_cast<uint32_t>(std::min<uint64_t>(th_phi, uint64_t{second} + second / 4 + 1));
+        pos.make_move(children[best]);
+        numbers[best] = search(pos, depth - 1, child_th_phi, child_th_delta);
+        pos.unmake_move(children[best]);
+    }
+}
+
+// Searches the node until it is solved. Returns true if it is proven, with
+// its numbers in 'numbers'.
+bool Solver::prove(Position& pos, int depth, Numbers& numbers) {
+    if (!table.probe(pos.hash_key, depth, numbers) || (numbers.pn && numbers.dn)) {
+        numbers = search(pos, depth, INFINITE, INFINITE);
+    }
+    return numbers.pn == 0;
+}
+
+// Follows a proven tree from the root: the attacker plays the check with the
+// shortest stored proof, the defender the reply with the longest. Entries
+// lost to replacement are proven again on the way; at attacker nodes that
+// stops at the first check proven, since disproving the others is not needed.
+std::vector<Move> Solver::mating_line(Position& pos, int depth) {
+    std::vector<Move> line;
+    Move children[MAX_MOVES];
+    for (; depth > 0 && !stop; --depth) {
+        const bool at_attacker = pos.side_to_move == attacker;
+        const int count = expand(pos, at_attacker, children);
+        Move best_move = MOVE_NONE;
+        int best_length = 0;
+        auto consider = [&](Move m, const Numbers& child) {
+            const bool better = at_attacker ? child.length < best_length : child.length > best_length;
+            if (best_move == MOVE_NONE || better) {
+                best_move = m;
+                best_length = child.length;
+            }
+        };
+        if (at_attacker) {
+            for (int i = 0; i < count; ++i) {
+                Numbers child;
+                if (table.probe(pos.key_after(children[i]), depth - 1, child) && child.pn == 0) {
+                    consider(children[i], child);
+                }
+            }
+        }
+        for (int i = 0; i < count && !(at_attacker && best_move != MOVE_NONE); ++i) {
+            Numbers child;
+            pos.make_move(children[i]);
+            const bool proven = prove(pos, depth - 1, child);
+            pos.unmake_move(children[i]);
+            if (proven) consider(children[i], child);
+        }
+        if (best_move == MOVE_NONE) break;
+        line.push_back(best_move);
+        pos.make_move(best_move);
+    }
+    for (auto it = line.rbegin(); it != line.rend(); ++it) pos.unmake_move(*it);
+    return line;
+}
+
+Result Solver::solve(Position& pos, const Limits& solve_limits) {
+    limits = solve_limits;
+    start_time_ms = now_ms();
+    nodes = 0;
+    attacker = pos.side_to_move;
+    if (table.size_mb() == 0) resize(16);
+    table.clear();
+
+    const int depth = 2 * std::clamp(limits.moves, 1, MAX_MATE_MOVES) - 1;
+    Result result;
+    Numbers root;
+    const bool proven = prove(pos, depth, root);
+    if (proven) {
+        result.outcome = Outcome::MATE;
+        result.length = root.length;
+        result.line = mating_line(pos, depth);
+    } else if (root.dn == 0) {
+        result.outcome = Outcome::NO_MATE;
+    }
+    result.nodes = nodes;
+    result.time_ms = now_ms() - start_time_ms;
+    return result;
+}
+
+} // namespace Mate
+} // namespace aetherchess
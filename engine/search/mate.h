@@ -0,0 +1,137 @@
+#pragma once
+
+#include "../core/memory.h"
+#include "../core/position.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace aetherchess {
+namespace Mate {
+
+// The longest mate the solver looks for, so that the line fits the position's
+// history together with the game moves.
+constexpr int MAX_MATE_MOVES = 63;
+
+// Proof and disproof numbers are 24 bits wide. INFINITE marks a solved node
+// and every other value saturates just below it.
+constexpr uint32_t INFINITE = (1u << 24) - 1;
+
+// Proof and disproof numbers of a node, from the attacker's point of view:
+// pn is the least number of leaves that must be proven to show a mate, dn the
+// least number that must be disproven to refute it. A proven node (pn == 0)
+// also has the length of its mate in plies.
+struct Numbers {
+    uint32_t pn = 1;
+    uint32_t dn = 1;
+    int length = 0;
+};
+
+// One 16-byte entry: the full key, the numbers, and the depth (remaining
+// plies) they were computed for, which a mate-in-N search needs alongside the
+// position. A proof holds for any depth at least its length and a disproof for
+// any depth up to its own.
+struct ProofEntry {
+    uint64_t key;
+    uint32_t pn_depth;  // pn in the low 24 bits, depth in the high 8
+    uint32_t dn_length; // dn in the low 24 bits, mate length in the high 8
+
+    uint32_t pn() const { return pn_depth & INFINITE; }
+    uint32_t dn() const { return dn_length & INFINITE; }
+    int depth() const { return static_cast<int>(pn_depth >> 24); }
+    int length() const { return static_cast<int>(dn_length >> 24); }
+};
+
+struct alignas(64) ProofCluster {
+    ProofEntry entries[4];
+};
+
+// The hash table of the mate solver, separate from the search's table because
+// it stores proof numbers rather than scores.
+class ProofTable {
+public:
+    // Throws std::bad_alloc if the table cannot be allocated.
+    void resize(size_t mb);
+    void clear() { memory.clear(); }
+    // Frees the table until the next resize.
+    void release();
+    size_t size_mb() const { return memory.size() / (1024 * 1024); }
+
+    // Finds numbers for 'key' that are valid at 'depth'. Returns false if none
+    // are stored.
+    bool probe(uint64_t key, int depth, Numbers& numbers) const;
+
+    // Stores the numbers of 'key' at 'depth', replacing the entry of the same
+    // key and depth, an empty one, or the one with the least depth.
+    void store(uint64_t key, int depth, const Numbers& numbers);
+
+private:
+    ProofCluster& cluster(uint64_t key) const {
+        return clusters[static_cast<size_t>((static_cast<unsigned __int128>(key) * cluster_count) >> 64)];
+    }
+
+    LargePageBuffer memory;
+    ProofCluster* clusters = nullptr;
+    size_t cluster_count = 0;
+};
+
+struct Limits {
+    int moves = 1;          // Find a mate in at most this many moves.
+    uint64_t nodes = 0;     // Zero means no limit.
+    int64_t movetime_ms = 0;
+};
+
+enum class Outcome { MATE, NO_MATE, UNKNOWN };
+
+struct Result {
+    Outcome outcome = Outcome::UNKNOWN;
+    // The proven bound on the mate's length in plies, and a line that mates
+    // within it, attacker and defender moves alternating. The line may be
+    // shorter: the proof bounds every defence but does not know the longest.
+    int length = 0;
+    std::vector<Move> line;
+    uint64_t nodes = 0;
+    int64_t time_ms = 0;
+};
+
+// Proves or refutes a forced mate by depth-first proof-number search (df-pn).
+// The side to move is the attacker and may only give check; the defender
+// tries every legal move. The tree is expanded toward the most promising
+// leaf under proof and disproof thresholds, so the search goes deep along
+// forcing lines where alpha-beta would search every move to the full depth.
+// The mate found is not necessarily the shortest, and in the mating line the
+// defender plays the longest resistance the proof contains.
+class Solver {
+public:
+    Solver() = default;
+
+    // Resizes the proof table; it is cleared before every solve.
+    void resize(size_t mb) { table.resize(mb); }
+    void release() { table.release(); }
+    size_t table_mb() const { return table.size_mb(); }
+
+    // Solves the position, which is restored on return. 'stop' may be raised
+    // from another thread to end the solve early; the caller lowers it first.
+    Result solve(Position& pos, const Limits& limits);
+
+    std::atomic<bool> stop{false};
+
+private:
+    Numbers search(Position& pos, int depth, uint32_t th_phi, uint32_t th_delta);
+    bool prove(Position& pos, int depth, Numbers& numbers);
+    std::vector<Move> mating_line(Position& pos, int depth);
+    void check_limits();
+
+    // Nodes between two looks at the clock and the node limit.
+    static constexpr uint64_t CHECK_INTERVAL = 1024;
+
+    ProofTable table;
+    Limits limits;
+    Color attacker = Color::WHITE;
+    uint64_t nodes = 0;
+    int64_t start_time_ms = 0;
+};
+
+} // namespace Mate
+} // namespace aetherchess
@@ -0,0 +1,304 @@
+#include "search.h"
+#include "../core/stats.h"
+#include "../eval/eval.h"
+#include "../movegen/movegen.h"
+#include "../tablebase/tablebase.h"
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+namespace aetherchess {
+namespace Search {
+
+static int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Mate scores are stored relative to the node rather than the root, so that a
+// transposition reached at a different ply reports the right distance.
+static int score_to_tt(int score, int ply) {
+    if (score >= VALUE_MATE_IN_MAX_PLY) return score + ply;
+    if (score <= -VALUE_MATE_IN_MAX_PLY) return score - ply;
+    return score;
+}
+
+static int score_from_tt(int score, int ply) {
+    if (score >= VALUE_MATE_IN_MAX_PLY) return score - ply;
+    if (score <= -VALUE_MATE_IN_MAX_PLY) return score + ply;
+    return score;
+}
+
+static bool is_capture(Move m) {
+    const MoveType type = Moves::get_type(m);
+    return type == CAPTURE || type == EN_PASSANT || type >= PROMO_CAPTURE_KNIGHT;
+}
+
+static const int piece_order_values[7] = {1, 3, 3, 5, 9, 20, 0};
+
+// Orders the TT move first, then captures by MVV-LVA and promotions, then
+// killers, then quiet moves by their history score.
+static void score_moves(const Position& pos, ScoredMoveList& list, Move tt_move,
+                        const Move killers[2], const int16_t history[64][64]) {
+    for (int i = 0; i < list.count; ++i) {
+        const Move m = list.moves[i].move;
+        const Square from = Moves::get_from(m);
+        const Square to = Moves::get_to(m);
+        int score;
+        if (m == tt_move) {
+            score = 30000;
+        } else if (is_capture(m)) {
+            const PieceType victim = Moves::get_type(m) == EN_PASSANT ? PieceType::PAWN : pos.piece_on_sq[to];
+            score = 20000 + 16 * piece_order_values[static_cast<int>(victim)] -
+                    piece_order_values[static_cast<int>(pos.piece_on_sq[from])];
+        } else if (Moves::get_type(m) == PROMO_QUEEN) {
+            score = 19000;
+        } else if (m == killers[0]) {
+            score = 18000;
+        } else if (m == killers[1]) {
+            score = 17000;
+        } else {
+            score = history[from][to];
+        }
+        list.moves[i].score = static_cast<int16_t>(score);
+    }
+}
+
+// Selection sort step: brings the best remaining move to index i.
+static Move pick_move(ScoredMoveList& list, int i) {
+    int best = i;
+    for (int j = i + 1; j < list.count; ++j) {
+        if (list.moves[j].score > list.moves[best].score) best = j;
+    }
+    std::swap(list.moves[i], list.moves[best]);
+    return list.moves[i].move;
+}
+
+void Worker::check_limits() {
+    if (root_depth <= 1) return; // Always finish the first iteration.
+    if (limits.nodes && nodes >= limits.nodes) stop = true;
+    if (time.hard_limit_reached(now_ms())) stop = true;
+}
+
+Result Worker::search(Position& pos, const Limits& search_limits, const InfoCallback& on_iteration) {
+    limits = search_limits;
+    start_time_ms = now_ms();
+    time.init(limits, pos.side_to_move, start_time_ms);
+    nodes = 0;
+    for (auto& k : killers) k[0] = k[1] = MOVE_NONE;
+    for (auto& side : history) for (auto& from : side) for (int16_t& h : from) h /= 2;
+
+    const TranspositionTable* saved_tt = pos.tt;
+    pos.tt = &tt;
+
+    Result result;
+    const int max_depth = std::clamp(limits.depth, 1, MAX_PLY - 1);
+    for (root_depth = 1; root_depth <= max_depth; ++root_depth) {
+        const int score = negamax(pos, root_depth, 0, -VALUE_INFINITE, VALUE_INFINITE);
+        if (stop && root_depth > 1) break;
+
+        result.score = score;
+        result.depth = root_depth;
+        result.pv.assign(pv_table[0], pv_table[0] + pv_length[0]);
+        result.best_move = result.pv.empty() ? MOVE_NONE : result.pv[0];
+        STATS_ITERATION(root_depth, nodes - result.nodes);
+        result.nodes = nodes;
+
+        if (on_iteration) on_iteration({root_depth, score, nodes, now_ms() - start_time_ms, result.pv});
+        if (limits.infinite) continue;
+        if (result.best_move == MOVE_NONE) break; // Mate or stalemate at the root
+        if (std::abs(score) >= VALUE_MATE_IN_MAX_PLY && VALUE_MATE - std::abs(score) < root_depth) break;
+        if (time.stop_after_iteration(now_ms(), root_depth, result.best_move, score)) break;
+    }
+
+    result.nodes = nodes;
+    pos.tt = saved_tt;
+    return result;
+}
+
+int Worker::negamax(Position& pos, int depth, int ply, int alpha, int beta) {
+    const bool pv_node = beta - alpha > 1;
+    const bool root = ply == 0;
+    pv_length[ply] = 0;
+
+    if (++nodes % CHECK_INTERVAL == 0) check_limits();
+    if (stop && root_depth > 1) return 0;
+    STATS_INC(SEARCH_NODES);
+
+    if (!root) {
+        if (pos.is_draw(ply)) return VALUE_DRAW;
+        if (ply >= MAX_PLY - 1) return Eval::evaluate(pos, eval_cache);
+
+        // If we can force a repetition with one move, the score is at least a draw.
+        if (alpha < VALUE_DRAW && pos.has_upcoming_repetition(ply)) {
+            alpha = VALUE_DRAW;
+            if (alpha >= beta) {
+                STATS_INC(REPETITION_PRUNES);
+                return alpha;
+            }
+        }
+
+        // Mate distance pruning.
+        alpha = std::max(alpha, -VALUE_MATE + ply);
+        beta = std::min(beta, VALUE_MATE - ply - 1);
+        if (alpha >= beta) {
+            STATS_INC(MATE_DISTANCE_PRUNES);
+            return alpha;
+        }
+
+        // Endgame tablebases know the exact distance to mate.
+        if (BB::count_bits(pos.color_bbs[0] | pos.color_bbs[1]) <= Tablebase::max_pieces()) {
+            STATS_TIMER(PHASE_TABLEBASE);
+            int wdl, dtm;
+            if (Tablebase::probe_dtm(pos, wdl, dtm)) {
+                STATS_INC(TABLEBASE_HITS);
+                return wdl == Tablebase::WDL_WIN    ? VALUE_MATE - ply - dtm
+                       : wdl == Tablebase::WDL_LOSS ? -VALUE_MATE + ply + dtm
+                                                    : VALUE_DRAW;
+            }
+        }
+    }
+
+    const bool in_check = pos.checkers() != 0;
+    if (in_check) depth++;
+    if (depth <= 0) return qsearch(pos, ply, alpha, beta);
+
+    bool tt_hit;
+    TTEntry* entry = tt.probe(pos.hash_key, tt_hit);
+    STATS_INC(TT_PROBES);
+    if (tt_hit) STATS_INC(TT_HITS);
+    const Move tt_move = tt_hit ? entry->move : MOVE_NONE;
+    if (tt_hit && !pv_node && entry->depth >= depth) {
+        const int tt_score = score_from_tt(entry->score, ply);
+        const Bound bound = entry->bound();
+        if (bound == BOUND_EXACT || (bound == BOUND_LOWER && tt_score >= beta) ||
+            (bound == BOUND_UPPER && tt_score <= alpha)) {
+            STATS_INC(TT_CUTOFFS);
+            return tt_score;
+        }
+    }
+
+    ScoredMoveList moves;
+    MoveGenerator::generate_moves(pos, moves);
+    const int us = static_cast<int>(pos.side_to_move);
+    score_moves(pos, moves, tt_move, killers[ply], history[us]);
+
+    const int original_alpha = alpha;
+    int best_score = -VALUE_INFINITE;
+    Move best_move = MOVE_NONE;
+    int legal = 0;
+
+    for (int i = 0; i < moves.count; ++i) {
+        const Move m = pick_move(moves, i);
+        if (root && !limits.search_moves.empty() &&
+            std::find(limits.search_moves.begin(), limits.search_moves.end(), m) == limits.search_moves.end()) {
+            continue;
+        }
+        if (!pos.make_move(m)) continue;
+        ++legal;
+
+        int score;
+        if (legal == 1) {
+            score = -negamax(pos, depth - 1, ply + 1, -beta, -alpha);
+        } else {
+            // Late quiet moves are searched with a reduced depth first.
+            const int reduction = (depth >= 3 && legal > 3 && !in_check && !is_capture(m) &&
+                                   Moves::get_type(m) < PROMO_KNIGHT && !pos.checkers()) ? 1 : 0;
+            if (reduction) STATS_INC(LMR_REDUCTIONS);
+            score = -negamax(pos, depth - 1 - reduction, ply + 1, -alpha - 1, -alpha);
+            if (score > alpha && (reduction || score < beta)) {
+                if (reduction) STATS_INC(LMR_RESEARCHES);
+                else STATS_INC(PVS_RESEARCHES);
+                score = -negamax(pos, depth - 1, ply + 1, -beta, -alpha);
+            }
+        }
+        pos.unmake_move(m);
+
+        if (stop && root_depth > 1) return 0;
+
+        if (score > best_score) {
+            best_score = score;
+            best_move = m;
+            if (score > alpha) {
+                alpha = score;
+                pv_table[ply][0] = m;
+                std::copy(pv_table[ply + 1], pv_table[ply + 1] + pv_length[ply + 1], pv_table[ply] + 1);
+                pv_length[ply] = pv_length[ply + 1] + 1;
+            }
+        }
+        if (alpha >= beta) {
+            STATS_INC(BETA_CUTOFFS);
+            if (legal == 1) STATS_INC(FIRST_MOVE_CUTOFFS);
+            if (!is_capture(m)) {
+                if (killers[ply][0] != m) {
+                    killers[ply][1] = killers[ply][0];
+                    killers[ply][0] = m;
+                }
+                int16_t& h = history[us][Moves::get_from(m)][Moves::get_to(m)];
+                h = static_cast<int16_t>(std::min(h + depth * depth, 16000));
+            }
+            break;
+        }
+    }
+
+    if (legal == 0) return in_check ? -VALUE_MATE + ply : VALUE_DRAW;
+
+    const Bound bound = best_score >= beta ? BOUND_LOWER : (alpha > original_alpha ? BOUND_EXACT : BOUND_UPPER);
+    tt.store(entry, pos.hash_key, best_move, score_to_tt(best_score, ply), 0, depth, bound);
+    return best_score;
+}
+
+int Worker::qsearch(Position& pos, int ply, int alpha, int beta) {
+    pv_length[ply] = 0;
+    if (++nodes % CHECK_INTERVAL == 0) check_limits();
+    if (stop && root_depth > 1) return 0;
+    STATS_INC(QSEARCH_NODES);
+    if (ply >= MAX_PLY - 1) return Eval::evaluate(pos, eval_cache);
+
+    const bool in_check = pos.checkers() != 0;
+    int best_score = -VALUE_INFINITE;
+    if (!in_check) {
+        best_score = Eval::evaluate(pos, eval_cache);
+        if (best_score >= beta) {
+            STATS_INC(STAND_PAT_CUTOFFS);
+            return best_score;
+        }
+        alpha = std::max(alpha, best_score);
+    }
+
+    ScoredMoveList moves;
+    MoveGenerator::generate_moves(pos, moves);
+    score_moves(pos, moves, MOVE_NONE, killers[ply], history[static_cast<int>(pos.side_to_move)]);
+
+    int legal = 0;
+    for (int i = 0; i < moves.count; ++i) {
+        const Move m = pick_move(moves, i);
+        // Out of check only captures and queen promotions are searched.
+        if (!in_check && !is_capture(m) && Moves::get_type(m) != PROMO_QUEEN) continue;
+        if (!pos.make_move(m)) continue;
+        ++legal;
+        const int score = -qsearch(pos, ply + 1, -beta, -alpha);
+        pos.unmake_move(m);
+
+        if (stop && root_depth > 1) return 0;
+        if (score > best_score) {
+            best_score = score;
+            if (score > alpha) alpha = score;
+            if (alpha >= beta) break;
+        }
+    }
+
+    if (in_check && legal == 0) return -VALUE_MATE + ply;
+    return best_score;
+}
+
+std::string score_to_uci(int score) {
+    if (std::abs(score) >= VALUE_MATE_IN_MAX_PLY) {
+        const int plies = VALUE_MATE - std::abs(score);
+        return "mate " + std::to_string(score > 0 ? (plies + 1) / 2 : -(plies + 1) / 2);
+    }
+    return "cp " + std::to_string(score);
+}
+
+} // namespace Search
+} // namespace aetherchess
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "../core/position.h"
+#include "../eval/eval_cache.h"
+#include "timeman.h"
+#include "tt.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace aetherchess {
+namespace Search {
+
+constexpr int MAX_PLY = 128;
+
+constexpr int VALUE_DRAW = 0;
+constexpr int VALUE_MATE = 32000;
+constexpr int VALUE_INFINITE = 32001;
+// Scores beyond this bound encode a forced mate in (VALUE_MATE - |score|) plies.
+constexpr int VALUE_MATE_IN_MAX_PLY = VALUE_MATE - MAX_PLY;
+
+// Limits for a single search. A zero value means "no limit".
+struct Limits {
+    int depth = MAX_PLY - 1;
+    uint64_t nodes = 0;
+    int64_t movetime_ms = 0;
+    // UCI "go infinite": iterate until stopped, ignoring the clock and the
+    // early exits on a found mate or a stable best move.
+    bool infinite = false;
+
+    // Clock state for time management.
+    int64_t wtime_ms = 0, btime_ms = 0;
+    int64_t winc_ms = 0, binc_ms = 0;
+    int movestogo = 0;
+    int64_t move_overhead_ms = 10;
+
+    // If not empty, only these root moves are searched (UCI "searchmoves").
+    std::vector<Move> search_moves;
+};
+
+// Reported after every completed iteration of iterative deepening.
+struct IterationInfo {
+    int depth;
+    int score;
+    uint64_t nodes;
+    int64_t time_ms;
+    const std::vector<Move>& pv;
+};
+
+using InfoCallback = std::function<void(const IterationInfo&)>;
+
+struct Result {
+    Move best_move = MOVE_NONE;
+    int score = 0;
+    int depth = 0;
+    uint64_t nodes = 0;
+    std::vector<Move> pv;
+};
+
+// A single search thread with its own move-ordering state. Workers may share a
+// transposition table; everything else is private to the worker.
+class Worker {
+public:
+    explicit Worker(TranspositionTable& tt) : tt(tt) {}
+
+    // Runs an iterative-deepening search on pos, which is restored on return.
+    // 'stop' may be raised from another thread to end the search early; the
+    // caller lowers it before starting. The caller also advances the table's
+    // generation, once for all the workers that share it.
+    Result search(Position& pos, const Limits& limits, const InfoCallback& on_iteration = {});
+
+    std::atomic<bool> stop{false};
+
+private:
+    int negamax(Position& pos, int depth, int ply, int alpha, int beta);
+    int qsearch(Position& pos, int ply, int alpha, int beta);
+    void check_limits();
+
+    // Nodes between two looks at the clock and the node limit.
+    static constexpr uint64_t CHECK_INTERVAL = 1024;
+
+    TranspositionTable& tt;
+    Eval::EvalCache eval_cache;
+    Limits limits;
+    TimeManager time;
+    int64_t start_time_ms = 0;
+    uint64_t nodes = 0;
+    int root_depth = 0;
+
+    Move killers[MAX_PLY][2] = {};
+    int16_t history[2][64][64] = {};
+
+    // Triangular principal variation table.
+    Move pv_table[MAX_PLY][MAX_PLY] = {};
+    int pv_length[MAX_PLY] = {};
+};
+
+// Converts a score to UCI "cp <x>" or "mate <y>" notation.
+std::string score_to_uci(int score);
+
+} // namespace Search
+} // namespace aetherchess
@@ -0,0 +1,66 @@
+#include "timeman.h"
+#include "search.h"
+#include <algorithm>
+
+namespace aetherchess {
+namespace Search {
+
+void TimeManager::init(const Limits& limits, Color us, int64_t start) {
+    start_ms = start;
+    soft_ms = hard_ms = 0;
+    scalable = false;
+    last_best = MOVE_NONE;
+    last_score = 0;
+    stability = 0;
+    if (limits.infinite) return;
+
+    const int64_t time = us == Color::WHITE ? limits.wtime_ms : limits.btime_ms;
+    const int64_t inc = us == Color::WHITE ? limits.winc_ms : limits.binc_ms;
+
+    if (time > 0) {
+        // Keep the overhead in reserve for communication and scheduling delays.
+        const int64_t available = std::max<int64_t>(time - limits.move_overhead_ms, 1);
+        const int moves_to_go = limits.movestogo > 0 ? std::min(limits.movestogo, 50) : 30;
+
+        // Never plan to use more than a fraction of the clock on one move,
+        // except on the last move before a time control.
+        const double max_share = moves_to_go == 1 ? 0.9 : 0.6;
+        hard_ms = std::max<int64_t>(1, std::min<int64_t>(static_cast<int64_t>(available * max_share),
+                                                         (available / moves_to_go + inc) * 5));
+        soft_ms = std::min(hard_ms, available / moves_to_go + inc * 3 / 4);
+        scalable = true;
+    }
+
+    if (limits.movetime_ms > 0) {
+        const int64_t movetime = std::max<int64_t>(limits.movetime_ms - limits.move_overhead_ms, 1);
+        hard_ms = hard_ms ? std::min(hard_ms, movetime) : movetime;
+        soft_ms = hard_ms;
+        scalable = false;
+    }
+}
+
+bool TimeManager::stop_after_iteration(int64_t now, int depth, Move best_move, int score) {
+    if (!enabled()) return false;
+
+    stability = best_move == last_best ? std::min(stability + 1, 10) : 0;
+    const int score_drop = last_best != MOVE_NONE ? last_score - score : 0;
+    last_best = best_move;
+    last_score = score;
+
+    const int64_t spent = now - start_ms;
+    if (!scalable) return spent >= soft_ms;
+    if (depth < 4) return spent >= soft_ms; // Too early for the trends to mean much.
+
+    // An unstable best move or a falling score asks for more time; a best
+    // move that has stood for many iterations for less.
+    const double stability_factor = 1.5 - 0.08 * stability;
+    const double score_factor = std::clamp(1.0 + score_drop / 100.0, 0.8, 1.6);
+    const int64_t target = std::min<int64_t>(hard_ms, static_cast<int64_t>(soft_ms * stability_factor * score_factor));
+
+    // The next iteration typically takes longer than all previous ones
+    // together, so do not start one that would overrun the target.
+    return spent >= target * 6 / 10;
+}
+
+} // namespace Search
+} // namespace aetherchess
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "../core/types.h"
+#include <cstdint>
+
+namespace aetherchess {
+namespace Search {
+
+struct Limits;
+
+// Allocates thinking time for one move from the clock state of a "go" command.
+//
+// The hard limit is never exceeded: the search polls it through
+// hard_limit_reached() and unwinds as soon as it passes. The soft limit is the
+// time we would like to spend; it is scaled after every iteration by how
+// stable the best move has been and how much the score moved, and the search
+// does not start an iteration it is unlikely to finish before it.
+class TimeManager {
+public:
+    // Sets up the budgets for the side to move. Without clock information
+    // (wtime/btime) only movetime, if any, is enforced as a hard limit.
+    void init(const Limits& limits, Color us, int64_t start_ms);
+
+    bool enabled() const { return hard_ms > 0; }
+    int64_t soft_limit() const { return soft_ms; }
+    int64_t hard_limit() const { return hard_ms; }
+    int64_t elapsed(int64_t now) const { return now - start_ms; }
+
+    bool hard_limit_reached(int64_t now) const { return hard_ms > 0 && now - start_ms >= hard_ms; }
+
+    // Called after each completed iteration with its best move and score.
+    // Returns true if the search should stop rather than start another one.
+    bool stop_after_iteration(int64_t now, int depth, Move best_move, int score);
+
+private:
+    int64_t start_ms = 0;
+    int64_t soft_ms = 0;
+    int64_t hard_ms = 0;
+    bool scalable = false;  // Soft limit derived from the clock (not movetime)
+
+    Move last_best = MOVE_NONE;
+    int last_score = 0;
+    int stability = 0;      // Iterations the best move has not changed
+};
+
+} // namespace Search
+} // namespace aetherchess
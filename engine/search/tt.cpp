@@ -0,0 +1,172 @@
+#include "tt.h"
+#include "../zobrist/zobrist.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <utility>
+
+namespace aetherchess {
+
+namespace {
+
+// --- File format ---
+//
+// header | zero padding up to DATA_OFFSET | clusters [cluster_count]
+//
+// The clusters are stored as they are in memory, in native byte order, and
+// start at a page boundary so that load() can map them in place.
+
+constexpr char FILE_MAGIC[8] = {'A', 'E', 'T', 'H', 'T', 'T', 0, 0};
+constexpr uint32_t FILE_VERSION = 1;
+constexpr size_t DATA_OFFSET = 64 * 1024; // A multiple of any Linux page size.
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t cluster_bytes; // sizeof(TTCluster), as a check on the entry layout
+    uint64_t zobrist_checksum;
+    uint64_t cluster_count;
+    uint8_t generation;
+    uint8_t reserved[31];
+};
+
+static_assert(sizeof(FileHeader) == 64, "FileHeader must stay 64 bytes");
+
+} // namespace
+
+void TranspositionTable::resize(size_t mb) {
+    const size_t count = std::max<size_t>(1, mb * 1024 * 1024 / sizeof(TTCluster));
+    // Release first so the old and the new table are never both resident.
+    memory.release();
+    clusters = nullptr;
+    cluster_count = 0;
+    if (!memory.allocate(count * sizeof(TTCluster))) throw std::bad_alloc();
+    clusters = static_cast<TTCluster*>(memory.data());
+    cluster_count = count;
+    generation = 0;
+}
+
+void TranspositionTable::clear() {
+    memory.clear();
+    generation = 0;
+}
+
+TTEntry* TranspositionTable::probe(uint64_t key, bool& found) {
+    TTEntry* const entries = clusters[index(key)].entries;
+
+    for (int i = 0; i < TT_CLUSTER_SIZE; ++i) {
+        if (entries[i].key == key || entries[i].gen_bound == 0) {
+            found = entries[i].gen_bound != 0;
+            return &entries[i];
+        }
+    }
+
+    // Replace the entry with the lowest depth, preferring entries from older searches.
+    TTEntry* replace = &entries[0];
+    auto worth = [this](const TTEntry& e) {
+        const int age = static_cast<uint8_t>(generation - (e.gen_bound & 0xFC)) / 4;
+        return e.depth - 8 * age;
+    };
+    for (int i = 1; i < TT_CLUSTER_SIZE; ++i) {
+        if (worth(entries[i]) < worth(*replace)) replace = &entries[i];
+    }
+    found = false;
+    return replace;
+}
+
+void TranspositionTable::store(TTEntry* entry, uint64_t key, Move move, int score, int eval, int depth, Bound bound) {
+    // Keep the old move if the new search did not produce one for this position.
+    if (move || entry->key != key) entry->move = move;
+
+    // Don't let a shallow non-exact result overwrite deeper information.
+    if (bound == BOUND_EXACT || entry->key != key || depth + 4 > entry->depth) {
+        entry->key = key;
+        entry->score = static_cast<int16_t>(score);
+        entry->eval = static_cast<int16_t>(eval);
+        entry->depth = static_cast<uint8_t>(std::max(depth, 0));
+        entry->gen_bound = static_cast<uint8_t>(generation | bound);
+    }
+}
+
+bool TranspositionTable::save(const std::string& path, std::string& error) const {
+    FileHeader header{};
+    std::memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+    header.version = FILE_VERSION;
+    header.cluster_bytes = sizeof(TTCluster);
+    header.zobrist_checksum = Zobrist::checksum();
+    header.cluster_count = cluster_count;
+    header.generation = generation;
+
+    const std::string temp_path = path + ".tmp";
+    std::FILE* file = std::fopen(temp_path.c_str(), "wb");
+    if (!file) {
+        error = "cannot create " + temp_path;
+        return false;
+    }
+    static const char padding[DATA_OFFSET - sizeof(FileHeader)] = {};
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+              std::fwrite(padding, sizeof(padding), 1, file) == 1 &&
+              std::fwrite(clusters, sizeof(TTCluster), cluster_count, file) == cluster_count;
+    ok = (std::fclose(file) == 0) && ok;
+    if (!ok) {
+        error = "write error on " + temp_path;
+    } else if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        error = "cannot rename " + temp_path + " to " + path;
+        ok = false;
+    }
+    if (!ok) std::remove(temp_path.c_str());
+    return ok;
+}
+
+bool TranspositionTable::load(const std::string& path, std::string& error) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+    FileHeader header;
+    const bool read = std::fread(&header, sizeof(header), 1, file) == 1;
+    std::fclose(file);
+
+    if (!read || std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) {
+        error = path + " is not a saved hash table";
+        return false;
+    }
+    if (header.version != FILE_VERSION || header.cluster_bytes != sizeof(TTCluster)) {
+        error = path + " is not a version " + std::to_string(FILE_VERSION) + " hash table";
+        return false;
+    }
+    if (header.zobrist_checksum != Zobrist::checksum()) {
+        error = path + " was saved by a build with different Zobrist keys";
+        return false;
+    }
+    LargePageBuffer mapped;
+    if (header.cluster_count == 0 || !mapped.map_file(path, DATA_OFFSET)) {
+        error = "cannot map " + path;
+        return false;
+    }
+    if (mapped.size() != header.cluster_count * sizeof(TTCluster)) {
+        error = path + " does not have the size its header gives";
+        return false;
+    }
+
+    memory = std::move(mapped);
+    clusters = static_cast<TTCluster*>(memory.data());
+    cluster_count = header.cluster_count;
+    generation = header.generation;
+    return true;
+}
+
+int TranspositionTable::hashfull() const {
+    int used = 0;
+    const size_t sample = std::min<size_t>(1000, cluster_count);
+    for (size_t i = 0; i < sample; ++i) {
+        for (const TTEntry& e : clusters[i].entries) {
+            if (e.gen_bound && (e.gen_bound & 0xFC) == generation) ++used;
+        }
+    }
+    return static_cast<int>(used * 1000 / (sample * TT_CLUSTER_SIZE));
+}
+
+} // namespace aetherchess
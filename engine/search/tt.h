@@ -0,0 +1,91 @@
+#pragma once
+
+#include "../core/memory.h"
+#include "../core/types.h"
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace aetherchess {
+
+// Bound type of a stored score.
+enum Bound : uint8_t {
+    BOUND_NONE  = 0,
+    BOUND_UPPER = 1, // Fail-low: the true score is at most the stored one.
+    BOUND_LOWER = 2, // Fail-high: the true score is at least the stored one.
+    BOUND_EXACT = BOUND_UPPER | BOUND_LOWER
+};
+
+// A single transposition table entry, 16 bytes.
+struct TTEntry {
+    uint64_t key;
+    Move move;
+    int16_t score;
+    int16_t eval;
+    uint8_t depth;
+    uint8_t gen_bound; // Generation in the upper 6 bits, Bound in the lower 2.
+
+    Bound bound() const { return static_cast<Bound>(gen_bound & 0x3); }
+};
+
+// The table is organized in clusters of four entries that share one cache line,
+// so a probe touches exactly one line.
+constexpr int TT_CLUSTER_SIZE = 4;
+
+struct alignas(64) TTCluster {
+    TTEntry entries[TT_CLUSTER_SIZE];
+};
+
+class TranspositionTable {
+public:
+    // Resizes the table to the given size in megabytes and clears it. The
+    // table lives in a LargePageBuffer and is cleared on several threads.
+    void resize(size_t mb);
+    void clear();
+
+    // Advances the generation counter. Called once per new search, before its
+    // workers start, so that entries from earlier searches are replaced first.
+    void new_search() { generation += 4; }
+
+    // Returns the entry for key if present (found = true), otherwise the entry
+    // that should be overwritten by the next store for key.
+    TTEntry* probe(uint64_t key, bool& found);
+
+    void store(TTEntry* entry, uint64_t key, Move move, int score, int eval, int depth, Bound bound);
+
+    // Pulls the cluster for key into cache ahead of the probe.
+    void prefetch(uint64_t key) const {
+        if (cluster_count) __builtin_prefetch(&clusters[index(key)]);
+    }
+
+    // Approximate fill rate of the table in permille, as reported by UCI hashfull.
+    int hashfull() const;
+
+    // Size and huge page backing of the table, for "info string".
+    std::string memory_info() const { return memory.describe(); }
+    size_t size_mb() const { return cluster_count * sizeof(TTCluster) / (1024 * 1024); }
+
+    // Writes the table to 'path', so that a later session can start from it.
+    // The file is written next to 'path' and renamed over it when complete.
+    bool save(const std::string& path, std::string& error) const;
+
+    // Replaces the table with one saved by save(). The file is mapped rather
+    // than read, so this returns at once whatever the size, and the table
+    // keeps the file's size. Files from another format version or from a
+    // build with different Zobrist keys are rejected, and on failure the
+    // current table is kept.
+    bool load(const std::string& path, std::string& error);
+
+private:
+    size_t index(uint64_t key) const {
+        // Multiply-shift maps the key onto the cluster count without a modulo.
+        return static_cast<size_t>((static_cast<unsigned __int128>(key) * cluster_count) >> 64);
+    }
+
+    LargePageBuffer memory;
+    TTCluster* clusters = nullptr;
+    size_t cluster_count = 0;
+    uint8_t generation = 0;
+};
+
+} // namespace aetherchess
@@ -0,0 +1,602 @@
+#include "tablebase.h"
+#include "tb_format.h"
+#include "../movegen/attacks.h"
+#include "../movegen/movegen.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace aetherchess {
+namespace Tablebase {
+
+namespace {
+
+// Working values of the generator, one byte per position: a win in n plies
+// is n (odd), a loss in n plies is 128 + n (even n).
+constexpr uint8_t INVALID = 255;
+constexpr uint8_t UNKNOWN = 254;
+constexpr uint8_t DRAW = 253;
+constexpr int MAX_DTM = 124;
+
+constexpr uint8_t win_in(int n) { return static_cast<uint8_t>(n); }
+constexpr uint8_t loss_in(int n) { return static_cast<uint8_t>(128 + n); }
+constexpr bool is_win(uint8_t v) { return v < 128; }
+
+// Runs f(begin, end) over [0, size) in chunks pulled by 'threads' threads.
+template <typename F>
+void parallel_for(uint64_t size, int threads, F&& f) {
+    constexpr uint64_t CHUNK = 1 << 14;
+    std::atomic<uint64_t> next{0};
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t) {
+        pool.emplace_back([&]() {
+            for (uint64_t begin = next.fetch_add(CHUNK); begin < size; begin = next.fetch_add(CHUNK)) {
+                f(begin, std::min(begin + CHUNK, size));
+            }
+        });
+    }
+    for (std::thread& th : pool) th.join();
+}
+
+// The best of the values of a position's moves, for the side to move: the
+// fastest win, else a draw, else the slowest loss. Values are a WDL and a
+// distance to mate in plies, from the side to move's point of view.
+struct BestValue {
+    bool any = false;
+    int rank = 0;
+    int wdl = WDL_DRAW;
+    int dtm = 0;
+
+    void consider(int w, int d) {
+        const int r = w == WDL_WIN ? 1000 - d : w == WDL_LOSS ? -1000 + d : 0;
+        if (!any || r > rank) {
+            any = true;
+            rank = r;
+            wdl = w;
+            dtm = w == WDL_DRAW ? 0 : d;
+        }
+    }
+
+    // Adds a move into a position worth 'child_wdl' and 'child_dtm' to the
+    // opponent.
+    void consider_child(int child_wdl, int child_dtm) { consider(-child_wdl, child_dtm + 1); }
+};
+
+// Squares of the pieces of the position with folded index 'index'.
+void decode_canonical(const Material& m, uint64_t index, int* sq) {
+    for (int i = m.count - 1; i >= 1; --i, index >>= 6) sq[i] = static_cast<int>(index & 63);
+    sq[0] = king_region_square(static_cast<int>(index), m.has_pawns());
+}
+
+// Retrograde analysis of one material combination.
+//
+// The working arrays cover the unfolded index space (64 squares for every
+// piece), so that the legal moves of a position and the un-moves leading to
+// it pair up one to one. Positions are first evaluated with the move
+// generator: mates, stalemates, and moves that capture or promote into an
+// already generated table are resolved directly; the remaining moves are
+// counted. Then, ply by ply, every position lost in n plies marks its
+// predecessors won in n + 1, and every position won in n plies decrements
+// its predecessors' counts; a predecessor whose count reaches zero is lost.
+// Symmetry is only exploited on the folded index, which is what gets written.
+//
+// A double push that allows an en passant capture leads to a position the
+// tables do not index. It is worth the better, for the side to move, of the
+// capture (into a smaller table) and its other moves, which are those of the
+// same position without the en passant square. The first pass treats such
+// pushes as ordinary moves into that position; later passes resolve them like
+// captures, with the values of the previous pass, until nothing changes. Each
+// pass settles the positions one more such push away from the end, and a pawn
+// double pushes at most once, so this takes a pass per pawn and one more.
+class Generator {
+public:
+    Generator(const Material& m, int threads) : m(m), threads(threads), pawns(m.has_pawns()) {
+        full_size = uint64_t(1) << (6 * m.count);
+        for (int s = 0; s < 2; ++s) {
+            value[s].assign(full_size, INVALID);
+            count[s].assign(full_size, 0);
+            exit_max[s].assign(full_size, 0);
+        }
+    }
+
+    bool run(std::string& error);
+    bool write(const std::string& path, std::string& error);
+
+    uint64_t wins = 0, draws = 0, losses = 0;
+    int longest = 0;
+
+private:
+    bool run_pass(std::string& error);
+    void evaluate_canonical(uint64_t canonical, Position& pos);
+    bool en_passant_value(Position& pos, const int* sq, Move push, int& wdl, int& dtm) const;
+    bool resolves_en_passant(int side, const int* sq, int to, int passed, Position& pos) const;
+    void retro_step(int side, uint64_t index, int n, Position& pos);
+    void note_ply(int n);
+
+    uint64_t full_index(const int* sq) const {
+        uint64_t index = 0;
+        for (int i = 0; i < m.count; ++i) index = (index << 6) | sq[i];
+        return index;
+    }
+
+    void decode_full(uint64_t index, int* sq) const {
+        for (int i = m.count - 1; i >= 0; --i, index >>= 6) sq[i] = static_cast<int>(index & 63);
+    }
+
+    void decode_canonical(uint64_t index, int* sq) const { Tablebase::decode_canonical(m, index, sq); }
+
+    const Material& m;
+    int threads;
+    bool pawns;
+    uint64_t full_size;
+    std::vector<uint8_t> value[2], count[2], exit_max[2];
+    std::vector<uint8_t> previous[2]; // Values of the previous pass
+    bool en_passant_exits = false;    // Resolve en passant pushes with 'previous'
+    std::atomic<bool> en_passant_pushes{false};
+    std::atomic<int> max_ply{0};
+    std::atomic<bool> failed{false};
+};
+
+void Generator::note_ply(int n) {
+    int current = max_ply.load(std::memory_order_relaxed);
+    while (n > current && !max_ply.compare_exchange_weak(current, n)) {}
+    if (n > MAX_DTM) failed = true;
+}
+
+// Places the pieces on an empty board. Returns false if the squares do not
+// form a position (shared squares, adjacent kings, pawns on the back ranks).
+static bool setup(Position& pos, const Material& m, const int* sq) {
+    Bitboard occupied = 0;
+    for (int i = 0; i < m.count; ++i) {
+        const Bitboard bit = 1ULL << sq[i];
+        if (occupied & bit) return false;
+        if (m.types[i] == PieceType::PAWN && (bit & (Bitboards::RANK_1 | Bitboards::RANK_8))) return false;
+        occupied |= bit;
+    }
+    if (Attacks::king_attacks[sq[0]] & (1ULL << sq[1])) return false;
+
+    for (auto& bbs : pos.piece_bbs) for (Bitboard& bb : bbs) bb = 0ULL;
+    for (Bitboard& bb : pos.color_bbs) bb = 0ULL;
+    std::fill(std::begin(pos.piece_on_sq), std::end(pos.piece_on_sq), PieceType::NONE);
+    std::fill(std::begin(pos.color_on_sq), std::end(pos.color_on_sq), Color::NONE);
+    for (int i = 0; i < m.count; ++i) {
+        const int c = static_cast<int>(m.colors[i]), pt = static_cast<int>(m.types[i]);
+        pos.piece_bbs[c][pt] |= 1ULL << sq[i];
+        pos.color_bbs[c] |= 1ULL << sq[i];
+        pos.piece_on_sq[sq[i]] = m.types[i];
+        pos.color_on_sq[sq[i]] = m.colors[i];
+    }
+    pos.castling_rights = NO_CASTLING;
+    pos.en_passant_sq = SQ_NONE;
+    pos.halfmove_clock = 0;
+    pos.fullmove_number = 1;
+    return true;
+}
+
+// The value, for the side to move, of the position after the double push
+// 'push' that allows an en passant capture. 'sq' are the squares before it.
+bool Generator::en_passant_value(Position& pos, const int* sq, Move push, int& wdl, int& dtm) const {
+    MoveList moves;
+    MoveGenerator::generate_moves(pos, moves);
+    bool other_moves = false;
+    BestValue best;
+    for (int i = 0; i < moves.count; ++i) {
+        const Move mv = moves.moves[i];
+        if (!pos.is_legal(mv)) continue;
+        if (Moves::get_type(mv) != EN_PASSANT) {
+            other_moves = true;
+            continue;
+        }
+        pos.make_move(mv);
+        int child_wdl, child_dtm;
+        const bool found = probe_dtm(pos, child_wdl, child_dtm);
+        pos.unmake_move(mv);
+        if (!found) return false;
+        best.consider_child(child_wdl, child_dtm);
+    }
+    if (other_moves) {
+        int after[MAX_TB_PIECES];
+        for (int i = 0; i < m.count; ++i) {
+            after[i] = sq[i] == Moves::get_from(push) ? Moves::get_to(push) : sq[i];
+        }
+        const uint8_t v = previous[static_cast<int>(pos.side_to_move)][full_index(after)];
+        if (v == UNKNOWN || v == DRAW) best.consider(WDL_DRAW, 0);
+        else if (is_win(v)) best.consider(WDL_WIN, v);
+        else best.consider(WDL_LOSS, v - 128);
+    }
+    wdl = best.wdl;
+    dtm = best.dtm;
+    return true;
+}
+
+void Generator::evaluate_canonical(uint64_t canonical, Position& pos) {
+    int sq[MAX_TB_PIECES];
+    decode_canonical(canonical, sq);
+    if (!setup(pos, m, sq)) return;
+
+    for (int side = 0; side < 2; ++side) {
+        pos.side_to_move = static_cast<Color>(side);
+        pos.history_ply = 0;
+        pos.hash_key = pos.calculate_hash();
+        pos.set_check_info();
+        if (pos.is_square_attacked(pos.king_square(static_cast<Color>(side ^ 1)), static_cast<Color>(side))) {
+            continue; // The side not to move is in check.
+        }
+
+        MoveList moves;
+        MoveGenerator::generate_moves(pos, moves);
+        int legal = 0, in_table = 0, best_win = 0, worst_loss = 0;
+        for (int i = 0; i < moves.count; ++i) {
+            const Move mv = moves.moves[i];
+            if (!pos.is_legal(mv)) continue;
+            ++legal;
+            const MoveType type = Moves::get_type(mv);
+            int wdl, dtm;
+            bool found;
+            if (type == DOUBLE_PAWN_PUSH) {
+                pos.make_move(mv);
+                const bool exit = can_capture_en_passant(pos);
+                if (exit) en_passant_pushes = true;
+                found = exit && en_passant_exits && en_passant_value(pos, sq, mv, wdl, dtm);
+                pos.unmake_move(mv);
+                if (!exit || !en_passant_exits) {
+                    ++in_table;
+                    continue;
+                }
+            } else if (type != CAPTURE && type < PROMO_KNIGHT) {
+                ++in_table;
+                continue;
+            } else {
+                // Captures and promotions leave this table; the target is done.
+                pos.make_move(mv);
+                found = probe_dtm(pos, wdl, dtm);
+                pos.unmake_move(mv);
+            }
+            if (!found) {
+                failed = true;
+                return;
+            }
+            if (wdl == WDL_LOSS) best_win = best_win ? std::min(best_win, dtm + 1) : dtm + 1;
+            else if (wdl == WDL_WIN) worst_loss = std::max(worst_loss, dtm + 1);
+            else ++in_table; // A drawing exit can never be refuted.
+        }
+
+        uint8_t v;
+        if (legal == 0) v = pos.checkers() ? loss_in(0) : DRAW;
+        else if (best_win) v = win_in(best_win);
+        else if (in_table == 0) v = loss_in(worst_loss);
+        else v = UNKNOWN;
+        if (v != UNKNOWN && v != DRAW) note_ply(is_win(v) ? v : v - 128);
+
+        // Every symmetric image of the position shares its value and counts.
+        const int transforms = pawns ? 2 : 8;
+        for (int t = 0; t < transforms; ++t) {
+            int image[MAX_TB_PIECES];
+            for (int i = 0; i < m.count; ++i) image[i] = transform_square(sq[i], t);
+            const uint64_t index = full_index(image);
+            std::atomic_ref<uint8_t>(value[side][index]).store(v, std::memory_order_relaxed);
+            std::atomic_ref<uint8_t>(count[side][index]).store(static_cast<uint8_t>(in_table), std::memory_order_relaxed);
+            std::atomic_ref<uint8_t>(exit_max[side][index]).store(static_cast<uint8_t>(worst_loss),
+                                                                   std::memory_order_relaxed);
+        }
+    }
+}
+
+// Whether the double push of the pawn now on 'to', over 'passed', into the
+// position with pieces on 'sq' and 'side' to move, is resolved as an exit
+// (see en_passant_value) rather than an ordinary move.
+bool Generator::resolves_en_passant(int side, const int* sq, int to, int passed, Position& pos) const {
+    if (!en_passant_exits) return false;
+    // Only a pawn beside the pushed one can capture it.
+    const int file = to & 7;
+    const Bitboard beside = (file > 0 ? 1ULL << (to - 1) : 0) | (file < 7 ? 1ULL << (to + 1) : 0);
+    bool capturer = false;
+    for (int i = 0; i < m.count; ++i) {
+        capturer |= m.types[i] == PieceType::PAWN && static_cast<int>(m.colors[i]) == side &&
+                    ((1ULL << sq[i]) & beside);
+    }
+    if (!capturer) return false;
+    setup(pos, m, sq);
+    pos.side_to_move = static_cast<Color>(side);
+    pos.en_passant_sq = static_cast<Square>(passed);
+    pos.history_ply = 0;
+    pos.hash_key = pos.calculate_hash();
+    pos.set_check_info();
+    return can_capture_en_passant(pos);
+}
+
+// Propagates the result of position 'index' (side to move 'side', decided in
+// n plies) to its predecessors, in which the other side is to move.
+void Generator::retro_step(int side, uint64_t index, int n, Position& pos) {
+    int sq[MAX_TB_PIECES];
+    decode_full(index, sq);
+    Bitboard occupied = 0;
+    for (int i = 0; i < m.count; ++i) occupied |= 1ULL << sq[i];
+
+    const int mover = side ^ 1;
+    const bool lost = !is_win(value[side][index]);
+    for (int i = 0; i < m.count; ++i) {
+        if (static_cast<int>(m.colors[i]) != mover) continue;
+        const int to = sq[i];
+
+        // Squares the piece on 'to' can have come from without capturing.
+        Bitboard origins;
+        if (m.types[i] == PieceType::PAWN) {
+            const int back = mover == static_cast<int>(Color::WHITE) ? -8 : 8;
+            const int from = to + back;
+            origins = 0;
+            if (from >= 8 && from < 56 && !(occupied & (1ULL << from))) {
+                origins |= 1ULL << from;
+                const int double_rank = mover == static_cast<int>(Color::WHITE) ? 3 : 4;
+                if ((to >> 3) == double_rank && !(occupied & (1ULL << (from + back)))) origins |= 1ULL << (from + back);
+            }
+        } else {
+            origins = Attacks::get_piece_attacks(m.types[i], static_cast<Square>(to), occupied) & ~occupied;
+        }
+
+        const int shift = 6 * (m.count - 1 - i);
+        while (origins) {
+            const int from = BB::pop_lsb(origins);
+            if (m.types[i] == PieceType::PAWN && std::abs(from - to) == 16 &&
+                resolves_en_passant(side, sq, to, (from + to) / 2, pos)) {
+                continue;
+            }
+            const uint64_t pred = index - (static_cast<uint64_t>(to) << shift) + (static_cast<uint64_t>(from) << shift);
+            std::atomic_ref<uint8_t> pred_value(value[mover][pred]);
+            uint8_t current = pred_value.load(std::memory_order_relaxed);
+            if (current == INVALID) continue;
+
+            if (lost) {
+                // Moving into a lost position wins; keep the fastest win.
+                while ((current == UNKNOWN || (is_win(current) && current > n + 1)) &&
+                       !pred_value.compare_exchange_weak(current, win_in(n + 1))) {}
+                note_ply(n + 1);
+            } else if (current == UNKNOWN) {
+                // One more move refuted; lost once none is left.
+                if (std::atomic_ref<uint8_t>(count[mover][pred]).fetch_sub(1) == 1) {
+                    const int plies = std::max<int>(n + 1, exit_max[mover][pred]);
+                    uint8_t expected = UNKNOWN;
+                    pred_value.compare_exchange_strong(expected, loss_in(plies));
+                    note_ply(plies);
+                }
+            }
+        }
+    }
+}
+
+bool Generator::run(std::string& error) {
+    for (int pass = 0;; ++pass) {
+        if (!run_pass(error)) return false;
+        const bool settled = pass > 0 && value[0] == previous[0] && value[1] == previous[1];
+        if (!en_passant_pushes || settled) return true;
+        if (pass > m.pawn_count()) {
+            error = m.name() + ": en passant passes do not converge";
+            return false;
+        }
+        for (int s = 0; s < 2; ++s) {
+            previous[s] = value[s];
+            value[s].assign(full_size, INVALID);
+            count[s].assign(full_size, 0);
+            exit_max[s].assign(full_size, 0);
+        }
+        max_ply = 0;
+        en_passant_exits = true;
+    }
+}
+
+bool Generator::run_pass(std::string& error) {
+    const uint64_t canonical = table_entries(m);
+    parallel_for(canonical, threads, [&](uint64_t begin, uint64_t end) {
+        auto pos = std::make_unique<Position>();
+        for (uint64_t i = begin; i < end && !failed; ++i) evaluate_canonical(i, *pos);
+    });
+    if (failed) {
+        error = m.name() + ": a capture or promotion leads to a missing table";
+        return false;
+    }
+
+    for (int n = 0; n <= max_ply && !failed; ++n) {
+        const uint8_t target = (n & 1) ? win_in(n) : loss_in(n);
+        parallel_for(2 * full_size, threads, [&](uint64_t begin, uint64_t end) {
+            auto pos = std::make_unique<Position>();
+            for (uint64_t i = begin; i < end; ++i) {
+                const int side = i >= full_size;
+                const uint64_t index = i - (side ? full_size : 0);
+                if (value[side][index] == target) retro_step(side, index, n, *pos);
+            }
+        });
+    }
+    if (failed) {
+        error = m.name() + ": distance to mate exceeds " + std::to_string(MAX_DTM) + " plies";
+        return false;
+    }
+    return true;
+}
+
+// Compresses one block of DTM values as run-length pairs, or copies it raw
+// if that is not shorter.
+static void append_block(const uint8_t* dtm, size_t length, std::vector<uint8_t>& out) {
+    std::vector<uint8_t> runs;
+    for (size_t i = 0; i < length && runs.size() < length;) {
+        size_t j = i + 1;
+        while (j < length && dtm[j] == dtm[i]) ++j;
+        runs.push_back(static_cast<uint8_t>(j - i));
+        runs.push_back(dtm[i]);
+        i = j;
+    }
+    if (runs.size() < length) out.insert(out.end(), runs.begin(), runs.end());
+    else out.insert(out.end(), dtm, dtm + length);
+}
+
+bool Generator::write(const std::string& path, std::string& error) {
+    const uint64_t entries = table_entries(m);
+    const uint64_t wdl_bytes = (entries + 3) / 4;
+    const uint64_t blocks = dtm_blocks(entries);
+
+    std::vector<uint8_t> wdl(2 * wdl_bytes, 0);
+    std::vector<uint32_t> offsets;
+    std::vector<uint8_t> data;
+    std::vector<uint8_t> dtm(DTM_BLOCK);
+
+    for (int side = 0; side < 2; ++side) {
+        for (uint64_t block = 0; block < blocks; ++block) {
+            const uint64_t first = block * DTM_BLOCK;
+            const size_t length = static_cast<size_t>(std::min<uint64_t>(DTM_BLOCK, entries - first));
+            for (size_t k = 0; k < length; ++k) {
+                const uint64_t index = first + k;
+                int sq[MAX_TB_PIECES];
+                decode_canonical(index, sq);
+                uint8_t v = value[side][full_index(sq)];
+                if (v == UNKNOWN) v = DRAW; // Never forced either way
+
+                // Draws and unreachable positions take the previous value,
+                // which the prober never reads, to lengthen the runs.
+                const uint8_t dont_care = k ? dtm[k - 1] : 0;
+                WdlCode code;
+                if (v == INVALID) { code = CODE_INVALID; dtm[k] = dont_care; }
+                else if (v == DRAW) { code = CODE_DRAW; dtm[k] = dont_care; ++draws; }
+                else if (is_win(v)) { code = CODE_WIN; dtm[k] = static_cast<uint8_t>((v + 1) / 2); ++wins; }
+                else { code = CODE_LOSS; dtm[k] = static_cast<uint8_t>((v - 128) / 2); ++losses; }
+                if (code == CODE_WIN || code == CODE_LOSS) longest = std::max<int>(longest, is_win(v) ? v : v - 128);
+                wdl[side * wdl_bytes + index / 4] |= static_cast<uint8_t>(code << (2 * (index % 4)));
+            }
+            offsets.push_back(static_cast<uint32_t>(data.size()));
+            append_block(dtm.data(), length, data);
+        }
+    }
+    offsets.push_back(static_cast<uint32_t>(data.size()));
+
+    TableHeader header{};
+    std::memcpy(header.magic, TB_MAGIC, sizeof(header.magic));
+    header.version = TB_VERSION;
+    header.piece_count = static_cast<uint32_t>(m.count);
+    header.entries = entries;
+    header.dtm_offsets_pos = sizeof(header) + wdl.size();
+    header.dtm_data_pos = header.dtm_offsets_pos + offsets.size() * sizeof(uint32_t);
+    std::strncpy(header.name, m.name().c_str(), sizeof(header.name) - 1);
+
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        error = "cannot create " + path;
+        return false;
+    }
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+              std::fwrite(wdl.data(), 1, wdl.size(), file) == wdl.size() &&
+              std::fwrite(offsets.data(), sizeof(uint32_t), offsets.size(), file) == offsets.size() &&
+              std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    ok = (std::fclose(file) == 0) && ok;
+    if (!ok) error = "write error on " + path;
+    return ok;
+}
+
+// The value of pos from its moves alone: every child is probed, or searched
+// the same way if the tables do not index it.
+bool search_moves(Position& pos, int& wdl, int& dtm) {
+    MoveList moves;
+    MoveGenerator::generate_moves(pos, moves);
+    BestValue best;
+    for (int i = 0; i < moves.count; ++i) {
+        const Move mv = moves.moves[i];
+        if (!pos.make_move(mv)) continue;
+        int child_wdl, child_dtm;
+        const bool found = probe_dtm(pos, child_wdl, child_dtm) ||
+                           (can_capture_en_passant(pos) && search_moves(pos, child_wdl, child_dtm));
+        pos.unmake_move(mv);
+        if (!found) return false;
+        best.consider_child(child_wdl, child_dtm);
+    }
+    if (!best.any) best.consider(pos.checkers() ? WDL_LOSS : WDL_DRAW, 0);
+    wdl = best.wdl;
+    dtm = best.dtm;
+    return true;
+}
+
+} // namespace
+
+bool verify(const std::string& name, int threads, std::string& error) {
+    const std::vector<Material> materials = enumerate_materials(MAX_TB_PIECES);
+    const auto it = std::find_if(materials.begin(), materials.end(),
+                                 [&](const Material& m) { return m.name() == name; });
+    if (it == materials.end()) {
+        error = "no table named " + name;
+        return false;
+    }
+    const Material& m = *it;
+
+    const auto start = std::chrono::steady_clock::now();
+    std::atomic<uint64_t> positions{0}, missing{0}, mismatches{0};
+    std::mutex output_mutex;
+    parallel_for(table_entries(m), std::max(1, threads), [&](uint64_t begin, uint64_t end) {
+        auto pos = std::make_unique<Position>();
+        for (uint64_t i = begin; i < end; ++i) {
+            int sq[MAX_TB_PIECES];
+            decode_canonical(m, i, sq);
+            if (!setup(*pos, m, sq)) continue;
+            for (int side = 0; side < 2; ++side) {
+                pos->side_to_move = static_cast<Color>(side);
+                pos->history_ply = 0;
+                pos->hash_key = pos->calculate_hash();
+                pos->set_check_info();
+                if (pos->is_square_attacked(pos->king_square(static_cast<Color>(side ^ 1)),
+                                            static_cast<Color>(side))) {
+                    continue;
+                }
+                ++positions;
+                int wdl, dtm, search_wdl, search_dtm;
+                if (!probe_dtm(*pos, wdl, dtm) || !search_moves(*pos, search_wdl, search_dtm)) {
+                    ++missing;
+                } else if ((wdl != search_wdl || dtm != search_dtm) && ++mismatches <= 10) {
+                    const std::lock_guard<std::mutex> lock(output_mutex);
+                    std::cout << "info string " << pos->to_fen() << ": table " << wdl << " dtm " << dtm
+                              << ", search " << search_wdl << " dtm " << search_dtm << std::endl;
+                }
+            }
+        }
+    });
+    if (missing) {
+        error = name + ": " + std::to_string(missing) + " positions or their children are not in the tables";
+        return false;
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << name << ": " << positions << " positions, " << mismatches << " mismatches, "
+              << static_cast<int>(seconds * 1000) << " ms" << std::endl;
+    return true;
+}
+
+bool generate(const GenerateOptions& options, std::string& error) {
+    const int threads = std::max(1, options.threads);
+    init(""); // Tables are reloaded one by one below, existing files included.
+
+    for (const Material& m : enumerate_materials(std::min(options.max_pieces, MAX_TB_PIECES))) {
+        const std::string path = options.directory + "/" + m.name() + ".atb";
+        std::string load_error;
+        if (load_table(m, path, load_error)) continue;
+
+        const auto start = std::chrono::steady_clock::now();
+        Generator generator(m, threads);
+        if (!generator.run(error) || !generator.write(path, error) || !load_table(m, path, error)) return false;
+
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        long bytes = 0;
+        if (file) {
+            std::fseek(file, 0, SEEK_END);
+            bytes = std::ftell(file);
+            std::fclose(file);
+        }
+        std::cout << m.name() << ": win " << generator.wins << " draw " << generator.draws << " loss "
+                  << generator.losses << ", longest mate " << generator.longest << " plies, " << bytes / 1024
+                  << " KiB, " << static_cast<int>(seconds * 1000) << " ms" << std::endl;
+    }
+    return true;
+}
+
+} // namespace Tablebase
+} // namespace aetherchess
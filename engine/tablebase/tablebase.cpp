@@ -0,0 +1,242 @@
+#include "tablebase.h"
+#include "tb_format.h"
+#include "../io/mapped_file.h"
+#include "../movegen/movegen.h"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+
+namespace aetherchess {
+namespace Tablebase {
+
+static const char PIECE_CHARS[6] = {'P', 'N', 'B', 'R', 'Q', 'K'};
+
+std::string Material::name() const {
+    std::string white = "K", black = "K";
+    for (int i = 2; i < count; ++i) {
+        (colors[i] == Color::WHITE ? white : black) += PIECE_CHARS[static_cast<int>(types[i])];
+    }
+    return white + "v" + black;
+}
+
+uint64_t Material::signature(bool flipped) const {
+    int counts[2][5] = {};
+    for (int i = 2; i < count; ++i) {
+        const int c = static_cast<int>(colors[i]) ^ (flipped ? 1 : 0);
+        ++counts[c][static_cast<int>(types[i])];
+    }
+    return material_signature(counts);
+}
+
+std::vector<Material> enumerate_materials(int max_pieces) {
+    static constexpr PieceType strength_order[5] = {PieceType::QUEEN, PieceType::ROOK, PieceType::BISHOP,
+                                                    PieceType::KNIGHT, PieceType::PAWN};
+    std::vector<Material> materials;
+    auto add = [&](std::initializer_list<std::pair<PieceType, Color>> pieces) {
+        Material m;
+        for (const auto& [pt, c] : pieces) {
+            m.types[m.count] = pt;
+            m.colors[m.count] = c;
+            ++m.count;
+        }
+        materials.push_back(m);
+    };
+
+    for (int i = 0; i < 5 && max_pieces >= 3; ++i) add({{strength_order[i], Color::WHITE}});
+    for (int i = 0; i < 5 && max_pieces >= 4; ++i) {
+        for (int j = i; j < 5; ++j) {
+            add({{strength_order[i], Color::WHITE}, {strength_order[j], Color::WHITE}});
+            add({{strength_order[i], Color::WHITE}, {strength_order[j], Color::BLACK}});
+        }
+    }
+
+    // Captures lead to fewer pieces and promotions to fewer pawns.
+    std::stable_sort(materials.begin(), materials.end(), [](const Material& a, const Material& b) {
+        return a.count != b.count ? a.count < b.count : a.pawn_count() < b.pawn_count();
+    });
+    return materials;
+}
+
+namespace {
+
+struct Table {
+    Material material;
+    MappedFile file;
+    uint64_t entries = 0;
+    uint64_t blocks = 0;
+    const uint8_t* wdl[2] = {};
+    const uint32_t* dtm_offsets = nullptr;
+    const uint8_t* dtm_data = nullptr;
+};
+
+std::vector<std::unique_ptr<Table>> tables;
+std::unordered_map<uint64_t, const Table*> by_signature;
+int largest = 0;
+
+} // namespace
+
+bool load_table(const Material& m, const std::string& path, std::string& error) {
+    auto table = std::make_unique<Table>();
+    table->material = m;
+    if (!table->file.open(path, false)) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(table->file.data());
+    const size_t size = table->file.size();
+    TableHeader header;
+    if (size < sizeof(header)) {
+        error = path + " is too small";
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    table->entries = table_entries(m);
+    table->blocks = dtm_blocks(table->entries);
+    const uint64_t wdl_bytes = (table->entries + 3) / 4;
+
+    if (std::memcmp(header.magic, TB_MAGIC, sizeof(TB_MAGIC)) != 0 || header.version != TB_VERSION) {
+        error = path + " is not a version " + std::to_string(TB_VERSION) + " table";
+    } else if (header.entries != table->entries || header.piece_count != static_cast<uint32_t>(m.count) ||
+               std::strncmp(header.name, m.name().c_str(), sizeof(header.name)) != 0) {
+        error = path + " does not match its material";
+    } else if (header.dtm_offsets_pos != sizeof(header) + 2 * wdl_bytes ||
+               header.dtm_data_pos != header.dtm_offsets_pos + (2 * table->blocks + 1) * sizeof(uint32_t) ||
+               header.dtm_data_pos > size) {
+        error = path + " has a corrupt layout";
+    } else {
+        table->wdl[0] = data + sizeof(header);
+        table->wdl[1] = table->wdl[0] + wdl_bytes;
+        table->dtm_offsets = reinterpret_cast<const uint32_t*>(data + header.dtm_offsets_pos);
+        table->dtm_data = data + header.dtm_data_pos;
+        if (header.dtm_data_pos + table->dtm_offsets[2 * table->blocks] != size) {
+            error = path + " is truncated";
+            return false;
+        }
+        by_signature[m.signature()] = table.get();
+        largest = std::max(largest, m.count);
+        tables.push_back(std::move(table));
+        return true;
+    }
+    return false;
+}
+
+int init(const std::string& directory) {
+    by_signature.clear();
+    tables.clear();
+    largest = 0;
+    if (directory.empty() || directory == "<empty>") return 0;
+
+    std::string error;
+    for (const Material& m : enumerate_materials(MAX_TB_PIECES)) {
+        load_table(m, directory + "/" + m.name() + ".atb", error);
+    }
+    return static_cast<int>(tables.size());
+}
+
+int max_pieces() {
+    return largest;
+}
+
+bool can_capture_en_passant(const Position& pos) {
+    if (pos.en_passant_sq == SQ_NONE) return false;
+    MoveList moves;
+    MoveGenerator::generate_moves(pos, moves);
+    for (int i = 0; i < moves.count; ++i) {
+        if (Moves::get_type(moves.moves[i]) == EN_PASSANT && pos.is_legal(moves.moves[i])) return true;
+    }
+    return false;
+}
+
+// Finds the table for pos and its index. Fails for unindexed positions.
+static const Table* locate(const Position& pos, int& stm, uint64_t& index) {
+    if (pos.castling_rights != NO_CASTLING || can_capture_en_passant(pos)) return nullptr;
+    if (BB::count_bits(pos.color_bbs[0] | pos.color_bbs[1]) > largest) return nullptr;
+
+    int counts[2][5];
+    for (int c = 0; c < 2; ++c)
+        for (int pt = 0; pt < 5; ++pt) counts[c][pt] = BB::count_bits(pos.piece_bbs[c][pt]);
+
+    bool flipped = false;
+    auto it = by_signature.find(material_signature(counts));
+    if (it == by_signature.end()) {
+        for (int pt = 0; pt < 5; ++pt) std::swap(counts[0][pt], counts[1][pt]);
+        it = by_signature.find(material_signature(counts));
+        if (it == by_signature.end()) return nullptr;
+        flipped = true;
+    }
+
+    // Read the squares in material order; a flipped position is mirrored
+    // vertically with the colors swapped.
+    const Material& m = it->second->material;
+    Bitboard remaining[2][6];
+    std::memcpy(remaining, pos.piece_bbs, sizeof(remaining));
+    int sq[MAX_TB_PIECES];
+    for (int i = 0; i < m.count; ++i) {
+        const int c = static_cast<int>(m.colors[i]) ^ (flipped ? 1 : 0);
+        const int s = BB::pop_lsb(remaining[c][static_cast<int>(m.types[i])]);
+        sq[i] = flipped ? s ^ 56 : s;
+    }
+    stm = static_cast<int>(pos.side_to_move) ^ (flipped ? 1 : 0);
+    index = canonical_index(m, sq);
+    return it->second;
+}
+
+static int wdl_code(const Table& t, int stm, uint64_t index) {
+    return (t.wdl[stm][index / 4] >> (2 * (index % 4))) & 3;
+}
+
+static int read_dtm(const Table& t, int stm, uint64_t index) {
+    const uint64_t block = index / DTM_BLOCK;
+    const uint32_t begin = t.dtm_offsets[stm * t.blocks + block];
+    const uint32_t length = t.dtm_offsets[stm * t.blocks + block + 1] - begin;
+    const uint8_t* p = t.dtm_data + begin;
+    const uint64_t block_entries = std::min<uint64_t>(DTM_BLOCK, t.entries - block * DTM_BLOCK);
+    uint64_t offset = index % DTM_BLOCK;
+    if (length == block_entries) return p[offset];
+    for (;; p += 2) {
+        if (offset < p[0]) return p[1];
+        offset -= p[0];
+    }
+}
+
+static bool bare_kings(const Position& pos) {
+    return (pos.color_bbs[0] | pos.color_bbs[1]) ==
+           (pos.piece_bbs[0][static_cast<int>(PieceType::KING)] | pos.piece_bbs[1][static_cast<int>(PieceType::KING)]);
+}
+
+bool probe_wdl(const Position& pos, int& wdl) {
+    int dtm;
+    if (bare_kings(pos)) return probe_dtm(pos, wdl, dtm);
+    int stm;
+    uint64_t index;
+    const Table* t = locate(pos, stm, index);
+    if (!t) return false;
+    const int code = wdl_code(*t, stm, index);
+    if (code == CODE_INVALID) return false;
+    wdl = code == CODE_WIN ? WDL_WIN : code == CODE_LOSS ? WDL_LOSS : WDL_DRAW;
+    return true;
+}
+
+bool probe_dtm(const Position& pos, int& wdl, int& dtm) {
+    if (bare_kings(pos)) {
+        wdl = WDL_DRAW;
+        dtm = 0;
+        return true;
+    }
+    int stm;
+    uint64_t index;
+    const Table* t = locate(pos, stm, index);
+    if (!t) return false;
+    const int code = wdl_code(*t, stm, index);
+    if (code == CODE_INVALID) return false;
+    wdl = code == CODE_WIN ? WDL_WIN : code == CODE_LOSS ? WDL_LOSS : WDL_DRAW;
+    if (wdl == WDL_DRAW) dtm = 0;
+    else if (wdl == WDL_WIN) dtm = 2 * read_dtm(*t, stm, index) - 1;
+    else dtm = 2 * read_dtm(*t, stm, index);
+    return true;
+}
+
+} // namespace Tablebase
+} // namespace aetherchess
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "../core/position.h"
+#include <string>
+
+namespace aetherchess {
+namespace Tablebase {
+
+enum Wdl : int { WDL_LOSS = -1, WDL_DRAW = 0, WDL_WIN = 1 };
+
+// Loads every table found in directory, replacing those loaded before.
+// Returns the number of tables loaded.
+int init(const std::string& directory);
+
+// Largest piece count (kings included) covered by the loaded tables, 0 if none.
+int max_pieces();
+
+// Looks pos up in the loaded tables. 'wdl' is from the side to move's point of
+// view and 'dtm' is the distance to mate in plies (0 for draws). Fails for
+// positions with castling rights or a legal en passant capture, which the
+// tables do not index, and for material without a table. probe_wdl is O(1); probe_dtm
+// additionally decodes one bounded compressed block.
+bool probe_wdl(const Position& pos, int& wdl);
+bool probe_dtm(const Position& pos, int& wdl, int& dtm);
+
+struct GenerateOptions {
+    std::string directory;
+    int max_pieces = 4;
+    int threads = 1;
+};
+
+// Generates the WDL/DTM tables for every material combination of up to
+// max_pieces pieces by retrograde analysis, writing one file per combination
+// into the directory and loading each as it is finished. Existing valid files
+// are loaded instead of regenerated. Prints one line of statistics per table.
+bool generate(const GenerateOptions& options, std::string& error);
+
+// Checks every position of the loaded table 'name' ("KPvKP") against a search
+// of its moves that probes the children, which also covers the double pushes
+// that allow an en passant capture. Prints the position and mismatch counts
+// and the first mismatches. Fails if the table or a child's is not loaded.
+bool verify(const std::string& name, int threads, std::string& error);
+
+} // namespace Tablebase
+} // namespace aetherchess
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "../core/position.h"
+#include "../core/types.h"
+#include "../bitboard/bitboard.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Layout shared by the tablebase generator and prober. Not part of the public
+// interface; see tablebase.h.
+
+namespace aetherchess {
+namespace Tablebase {
+
+constexpr int MAX_TB_PIECES = 4;
+
+// The pieces of one material combination in index order: the white king, the
+// black king, then the white and the black pieces, strongest first. White is
+// always the stronger side; positions with the colors the other way round are
+// looked up color-flipped.
+struct Material {
+    int count = 2;
+    PieceType types[MAX_TB_PIECES] = {PieceType::KING, PieceType::KING};
+    Color colors[MAX_TB_PIECES] = {Color::WHITE, Color::BLACK};
+
+    bool has_pawns() const {
+        for (int i = 2; i < count; ++i) if (types[i] == PieceType::PAWN) return true;
+        return false;
+    }
+    int pawn_count() const {
+        int n = 0;
+        for (int i = 2; i < count; ++i) n += types[i] == PieceType::PAWN;
+        return n;
+    }
+
+    // "KQvKR" style name, also used for the file name.
+    std::string name() const;
+
+    // 4 bits per (color, non-king piece type), colors swapped if 'flipped'.
+    uint64_t signature(bool flipped = false) const;
+};
+
+// Signature of a position from its piece counts, indexed [color][PAWN..QUEEN].
+inline uint64_t material_signature(const int counts[2][5]) {
+    uint64_t sig = 0;
+    for (int c = 0; c < 2; ++c)
+        for (int pt = 0; pt < 5; ++pt) sig |= static_cast<uint64_t>(counts[c][pt]) << (4 * (5 * c + pt));
+    return sig;
+}
+
+// All material combinations with 3 to max_pieces pieces, ordered so that every
+// table comes after the tables its captures and promotions lead into.
+std::vector<Material> enumerate_materials(int max_pieces);
+
+// --- Symmetry and indexing ---
+//
+// A transform is a bitmask applied in order: bit 0 mirrors the files, bit 1
+// the ranks, bit 2 flips along the a1-h8 diagonal. Pawnless tables use all
+// eight and keep the white king in the a1-d1-d4 triangle (10 squares); tables
+// with pawns only mirror files and keep it on files a-d (32 squares).
+
+inline int transform_square(int s, int t) {
+    if (t & 1) s ^= 7;
+    if (t & 2) s ^= 56;
+    if (t & 4) s = ((s & 7) << 3) | (s >> 3);
+    return s;
+}
+
+inline int canonical_transform(int white_king, bool pawns) {
+    int t = (white_king & 7) > 3 ? 1 : 0;
+    if (pawns) return t;
+    int s = transform_square(white_king, t);
+    if ((s >> 3) > 3) {
+        t |= 2;
+        s ^= 56;
+    }
+    if ((s >> 3) > (s & 7)) t |= 4;
+    return t;
+}
+
+constexpr int TRIANGLE_SQUARES[10] = {0, 1, 2, 3, 9, 10, 11, 18, 19, 27};
+
+inline int king_region_size(bool pawns) { return pawns ? 32 : 10; }
+
+// Index of a canonical white king square within its region, and back.
+inline int king_region_index(int s, bool pawns) {
+    if (pawns) return (s >> 3) * 4 + (s & 7);
+    for (int i = 0; i < 10; ++i) if (TRIANGLE_SQUARES[i] == s) return i;
+    return -1;
+}
+
+inline int king_region_square(int i, bool pawns) {
+    return pawns ? (i / 4) * 8 + i % 4 : TRIANGLE_SQUARES[i];
+}
+
+// Positions per side to move: the king region times 64 squares per other piece.
+inline uint64_t table_entries(const Material& m) {
+    return static_cast<uint64_t>(king_region_size(m.has_pawns())) << (6 * (m.count - 1));
+}
+
+// Index of the position with the pieces on sq[] (in material order, white to
+// be the stronger side) after folding it by symmetry.
+inline uint64_t canonical_index(const Material& m, const int* sq) {
+    const bool pawns = m.has_pawns();
+    const int t = canonical_transform(sq[0], pawns);
+    uint64_t index = king_region_index(transform_square(sq[0], t), pawns);
+    for (int i = 1; i < m.count; ++i) index = (index << 6) | transform_square(sq[i], t);
+    return index;
+}
+
+// --- File format ---
+//
+// header | WDL bits [2][entries / 4] | DTM block offsets uint32 [2 * blocks + 1] | DTM blocks
+//
+// WDL codes are 2 bits per position, four to a byte, low bits first: 0 draw,
+// 1 win and 2 loss for the side to move, 3 unreachable. DTM is the distance to
+// mate in moves: wins are mates in 2 * dtm - 1 plies and losses in 2 * dtm
+// plies; it is undefined for draws and unreachable positions. It is stored in
+// blocks of DTM_BLOCK positions, each either raw or as (run length, value)
+// byte pairs, whichever is shorter; a block is raw exactly when its stored
+// size equals its entry count.
+
+constexpr char TB_MAGIC[8] = {'A', 'E', 'T', 'H', 'T', 'B', 0, 0};
+// Version 2 resolves double pushes that allow an en passant capture.
+constexpr uint32_t TB_VERSION = 2;
+constexpr int DTM_BLOCK = 128;
+
+enum WdlCode : uint8_t { CODE_DRAW, CODE_WIN, CODE_LOSS, CODE_INVALID };
+
+struct TableHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t piece_count;
+    uint64_t entries;          // Positions per side to move
+    uint64_t dtm_offsets_pos;  // File offset of the DTM block offsets
+    uint64_t dtm_data_pos;     // File offset of the first DTM block
+    char name[16];
+    uint8_t reserved[8];
+};
+
+static_assert(sizeof(TableHeader) == 64, "TableHeader must stay 64 bytes");
+
+inline uint64_t dtm_blocks(uint64_t entries) { return (entries + DTM_BLOCK - 1) / DTM_BLOCK; }
+
+// Maps the table file at path and registers it for probing.
+bool load_table(const Material& m, const std::string& path, std::string& error);
+
+// Whether the side to move has a legal en passant capture. Positions with one
+// are not indexed; an en passant square that cannot be used is ignored.
+bool can_capture_en_passant(const Position& pos);
+
+} // namespace Tablebase
+} // namespace aetherchess
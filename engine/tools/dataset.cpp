@@ -0,0 +1,86 @@
+#include "dataset.h"
+#include "../io/dataset.h"
+#include "../io/packed_position.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+namespace aetherchess {
+namespace Dataset {
+
+void pack(const std::string& input_path, const std::string& output_path) {
+    MappedFile input;
+    if (!input.open(input_path)) {
+        std::cout << "info string Cannot open " << input_path << std::endl;
+        return;
+    }
+    DatasetWriter<PackedPosition> writer;
+    if (!writer.open(output_path)) {
+        std::cout << "info string Cannot create " << output_path << std::endl;
+        return;
+    }
+
+    auto pos = std::make_unique<Position>();
+    uint64_t line_number = 0, skipped = 0;
+    std::string_view rest = input.view();
+    while (!rest.empty()) {
+        const std::string_view line = IO::next_line(rest);
+        ++line_number;
+        if (line.empty()) continue;
+
+        PackedPosition packed;
+        const FenResult result = pos->set_from_fen(line);
+        if (!result || !Packed::encode(*pos, packed)) {
+            if (++skipped <= 10) {
+                std::cout << "info string Skipping line " << line_number << ": "
+                          << (result ? "more than 32 pieces or a move counter above 65535"
+                                     : fen_error_string(result.error))
+                          << std::endl;
+            }
+            continue;
+        }
+        writer.write(packed);
+    }
+
+    const uint64_t written = writer.size();
+    if (!writer.close()) {
+        std::cout << "info string Write error on " << output_path << std::endl;
+        return;
+    }
+    std::cout << "Packed " << written << " positions (" << skipped << " skipped) into " << output_path
+              << " (" << sizeof(DatasetHeader) + written * sizeof(PackedPosition) << " bytes)" << std::endl;
+}
+
+void verify(const std::string& path, int threads) {
+    DatasetReader<PackedPosition> reader;
+    std::string error;
+    if (!reader.open(path, error)) {
+        std::cout << "info string " << error << std::endl;
+        return;
+    }
+
+    std::atomic<uint64_t> mismatches{0};
+    const auto start = std::chrono::steady_clock::now();
+
+    // One scratch Position per thread; Position carries its full history array.
+    std::vector<std::unique_ptr<Position>> scratch;
+    for (int t = 0; t < std::max(1, threads); ++t) scratch.push_back(std::make_unique<Position>());
+
+    reader.parallel_for_each(threads, [&](const PackedPosition& record, size_t, int thread_id) {
+        Position& pos = *scratch[thread_id];
+        PackedPosition again;
+        if (!Packed::decode(record, pos) || !Packed::encode(pos, again) ||
+            std::memcmp(&record, &again, sizeof(record)) != 0) {
+            ++mismatches;
+        }
+    });
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Records: " << reader.size() << "\nMismatches: " << mismatches
+              << "\nPositions/second: " << static_cast<uint64_t>(reader.size() / std::max(seconds, 1e-9)) << std::endl;
+}
+
+} // namespace Dataset
+} // namespace aetherchess
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+
+namespace aetherchess {
+namespace Dataset {
+
+// Converts a text file with one FEN/EPD record per line into a packed binary
+// dataset. Invalid lines are reported and skipped.
+void pack(const std::string& input_path, const std::string& output_path);
+
+// Decodes every record of a packed dataset on 'threads' threads, checks that
+// re-encoding reproduces it bit for bit, and reports the decode throughput.
+void verify(const std::string& path, int threads);
+
+} // namespace Dataset
+} // namespace aetherchess
@@ -0,0 +1,227 @@
+#include "epd.h"
+#include "../core/san.h"
+#include "../core/stats.h"
+#include "../io/mapped_file.h"
+#include "../perft.h"
+#include "../uci/uci.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace aetherchess {
+namespace EPD {
+
+// Reads the move operands of a "bm"/"am" operation up to its ';'.
+static bool parse_moves(const Position& pos, std::string_view operands, std::vector<Move>& out, std::string& error) {
+    while (!operands.empty()) {
+        const size_t start = operands.find_first_not_of(" \t");
+        if (start == std::string_view::npos) break;
+        operands.remove_prefix(start);
+        const size_t end = std::min(operands.find_first_of(" \t"), operands.size());
+        const std::string_view token = operands.substr(0, end);
+        operands.remove_prefix(end);
+
+        Move m = SAN::to_move(pos, token);
+        if (m == MOVE_NONE) m = UCI::to_move(pos, std::string(token));
+        if (m == MOVE_NONE) {
+            error = "unknown move '" + std::string(token) + "'";
+            return false;
+        }
+        out.push_back(m);
+    }
+    return true;
+}
+
+bool parse_record(std::string_view line, Record& record, std::string& error) {
+    auto pos = std::make_unique<Position>();
+    const FenResult result = pos->set_from_fen(line);
+    if (!result) {
+        error = fen_error_string(result.error);
+        return false;
+    }
+    record.fen = std::string(line.substr(0, result.offset));
+
+    // Operations are "opcode operand*;" sequences. Quoted operands may contain ';'.
+    std::string_view ops = line.substr(result.offset);
+    while (!ops.empty()) {
+        const size_t start = ops.find_first_not_of(" \t");
+        if (start == std::string_view::npos) break;
+        ops.remove_prefix(start);
+
+        size_t end = 0;
+        bool quoted = false;
+        while (end < ops.size() && (quoted || ops[end] != ';')) {
+            if (ops[end] == '"') quoted = !quoted;
+            ++end;
+        }
+        const std::string_view op = ops.substr(0, end);
+        ops.remove_prefix(std::min(end + 1, ops.size()));
+
+        const size_t split = std::min(op.find_first_of(" \t"), op.size());
+        const std::string_view opcode = op.substr(0, split);
+        const std::string_view operands = op.substr(split);
+
+        if (opcode == "bm") {
+            if (!parse_moves(*pos, operands, record.best_moves, error)) return false;
+        } else if (opcode == "am") {
+            if (!parse_moves(*pos, operands, record.avoid_moves, error)) return false;
+        } else if (opcode == "id") {
+            // The id is the quoted string, or the bare operand; "id;" leaves it empty.
+            const size_t first = operands.find_first_not_of(" \t");
+            const size_t last = operands.find_last_not_of(" \t");
+            std::string_view id = first == std::string_view::npos ? std::string_view()
+                                                                  : operands.substr(first, last - first + 1);
+            if (id.size() >= 2 && id.front() == '"' && id.back() == '"') id = id.substr(1, id.size() - 2);
+            record.id = std::string(id);
+        }
+    }
+    return true;
+}
+
+namespace {
+
+struct Outcome {
+    bool solved = false;
+    Move best_move = MOVE_NONE;
+    int score = 0;
+    int depth = 0;
+    uint64_t nodes = 0;
+    int64_t time_ms = 0;
+    // When the final answer was first found and kept until the end; -1 if never.
+    int64_t solve_time_ms = -1;
+    uint64_t solve_nodes = 0;
+    int solve_depth = 0;
+};
+
+bool is_solution(const Record& record, Move m) {
+    if (m == MOVE_NONE) return false;
+    if (!record.best_moves.empty() &&
+        std::find(record.best_moves.begin(), record.best_moves.end(), m) == record.best_moves.end()) {
+        return false;
+    }
+    return std::find(record.avoid_moves.begin(), record.avoid_moves.end(), m) == record.avoid_moves.end();
+}
+
+} // namespace
+
+void run_suite(const std::string& path, const SuiteOptions& options) {
+    MappedFile file;
+    if (!file.open(path)) {
+        std::cout << "info string Cannot open " << path << std::endl;
+        return;
+    }
+
+    std::vector<Record> records;
+    std::string_view rest = file.view();
+    for (int line_number = 1; !rest.empty(); ++line_number) {
+        const std::string_view line = IO::next_line(rest);
+        if (line.find_first_not_of(" \t") == std::string_view::npos || line[0] == '#') continue;
+
+        Record record;
+        std::string error;
+        if (!parse_record(line, record, error)) {
+            std::cout << "info string Skipping line " << line_number << ": " << error << std::endl;
+            continue;
+        }
+        if (record.best_moves.empty() && record.avoid_moves.empty()) continue;
+        if (record.id.empty()) record.id = "line " + std::to_string(line_number);
+        records.push_back(std::move(record));
+    }
+
+    const int thread_count = std::clamp(options.threads, 1, static_cast<int>(std::max<size_t>(records.size(), 1)));
+    std::cout << "info string Running " << records.size() << " positions on " << thread_count << " threads" << std::endl;
+
+    std::vector<Outcome> outcomes(records.size());
+    std::atomic<size_t> next_index{0};
+    std::atomic<size_t> finished{0};
+    std::mutex output_mutex;
+    Stats::Counters stats;
+    const auto start = std::chrono::steady_clock::now();
+
+    // Each worker pulls positions off a shared counter, so long searches on
+    // hard positions do not hold up the rest of the suite.
+    auto worker_main = [&]() {
+        TranspositionTable tt;
+        tt.resize(options.hash_mb);
+        auto worker = std::make_unique<Search::Worker>(tt);
+        auto pos = std::make_unique<Position>();
+
+        for (size_t i = next_index++; i < records.size(); i = next_index++) {
+            const Record& record = records[i];
+            Outcome& outcome = outcomes[i];
+            pos->set_from_fen(record.fen);
+            tt.clear();
+            tt.new_search();
+            worker->stop = false;
+
+            const Search::Result result = worker->search(*pos, options.limits, [&](const Search::IterationInfo& info) {
+                if (info.pv.empty() || !is_solution(record, info.pv[0])) {
+                    outcome.solve_time_ms = -1;
+                } else if (outcome.solve_time_ms < 0) {
+                    outcome.solve_time_ms = info.time_ms;
+                    outcome.solve_nodes = info.nodes;
+                    outcome.solve_depth = info.depth;
+                }
+                outcome.time_ms = info.time_ms;
+            });
+
+            outcome.best_move = result.best_move;
+            outcome.score = result.score;
+            outcome.depth = result.depth;
+            outcome.nodes = result.nodes;
+            outcome.solved = is_solution(record, result.best_move);
+            if (!outcome.solved) outcome.solve_time_ms = -1;
+
+            std::lock_guard<std::mutex> lock(output_mutex);
+            std::cout << "info string " << ++finished << "/" << records.size() << " " << record.id
+                      << (outcome.solved ? " solved" : " failed") << std::endl;
+        }
+
+        const Stats::Counters thread_stats = Stats::take();
+        std::lock_guard<std::mutex> lock(output_mutex);
+        stats += thread_stats;
+    };
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_count; ++t) threads.emplace_back(worker_main);
+    for (std::thread& t : threads) t.join();
+
+    const double wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    int solved = 0;
+    uint64_t total_nodes = 0, solve_nodes = 0;
+    int64_t solve_time = 0;
+    std::cout << std::left << std::setw(16) << "id" << std::setw(8) << "result" << std::setw(8) << "move"
+              << std::setw(12) << "score" << std::setw(7) << "depth" << std::setw(12) << "tts(ms)"
+              << std::setw(14) << "nts" << "nodes" << std::endl;
+    for (size_t i = 0; i < records.size(); ++i) {
+        const Outcome& o = outcomes[i];
+        total_nodes += o.nodes;
+        if (o.solved) {
+            ++solved;
+            solve_time += o.solve_time_ms;
+            solve_nodes += o.solve_nodes;
+        }
+        std::cout << std::setw(16) << records[i].id << std::setw(8) << (o.solved ? "ok" : "FAIL")
+                  << std::setw(8) << (o.best_move ? Perft::move_to_string(o.best_move) : "none") << std::setw(12) << Search::score_to_uci(o.score)
+                  << std::setw(7) << o.depth << std::setw(12) << (o.solved ? std::to_string(o.solve_time_ms) : "-")
+                  << std::setw(14) << (o.solved ? std::to_string(o.solve_nodes) : "-") << o.nodes << std::endl;
+    }
+
+    std::cout << std::right << "\nSolved: " << solved << "/" << records.size();
+    if (solved) {
+        std::cout << "\nAverage time to solution: " << solve_time / solved << " ms"
+                  << "\nAverage nodes to solution: " << solve_nodes / solved;
+    }
+    std::cout << "\nTotal nodes: " << total_nodes << "\nWall time: " << std::fixed << std::setprecision(2)
+              << wall_seconds << " s" << std::defaultfloat << std::endl;
+    if (Stats::ENABLED) Stats::print_info(std::cout, stats);
+}
+
+} // namespace EPD
+} // namespace aetherchess
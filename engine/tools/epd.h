@@ -0,0 +1,35 @@
+#pragma once
+
+#include "../search/search.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace aetherchess {
+namespace EPD {
+
+// One test position of an EPD suite with the operations the runner scores.
+struct Record {
+    std::string fen;
+    std::string id;
+    std::vector<Move> best_moves;  // "bm": the engine must choose one of these.
+    std::vector<Move> avoid_moves; // "am": the engine must choose none of these.
+};
+
+// Parses one EPD line. Move operands are SAN (UCI coordinates are accepted
+// as well). Returns false, with 'error' set, if the position is invalid or an
+// operand names no legal move.
+bool parse_record(std::string_view line, Record& record, std::string& error);
+
+struct SuiteOptions {
+    Search::Limits limits;
+    int threads = 1;
+    size_t hash_mb = 16;
+};
+
+// Searches every position of the suite in 'path' on a pool of worker threads
+// and prints per-position and aggregate solve statistics.
+void run_suite(const std::string& path, const SuiteOptions& options);
+
+} // namespace EPD
+} // namespace aetherchess
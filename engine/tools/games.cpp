@@ -0,0 +1,68 @@
+#include "games.h"
+#include "../core/san.h"
+#include "../io/pgn.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+
+namespace aetherchess {
+namespace Games {
+
+namespace {
+
+struct Totals {
+    std::atomic<uint64_t> results[4] = {};
+    std::atomic<uint64_t> san_mismatches{0};
+};
+
+class ScanVisitor : public PGN::Visitor {
+public:
+    ScanVisitor(Totals& totals, bool check_san) : totals(totals), check_san(check_san) {}
+
+    void move(Position& pos, Move m) override {
+        if (check_san && SAN::to_move(pos, SAN::to_string(pos, m)) != m) ++san_mismatches;
+    }
+
+    void end_game(PGN::GameResult result, bool ok) override {
+        if (ok) ++results[static_cast<int>(result)];
+    }
+
+    ~ScanVisitor() override {
+        for (int i = 0; i < 4; ++i) totals.results[i] += results[i];
+        totals.san_mismatches += san_mismatches;
+    }
+
+private:
+    Totals& totals;
+    bool check_san;
+    uint64_t results[4] = {};
+    uint64_t san_mismatches = 0;
+};
+
+} // namespace
+
+void scan(const std::string& path, int threads, bool check_san) {
+    Totals totals;
+    PGN::Stats stats;
+    const auto start = std::chrono::steady_clock::now();
+    const bool opened = PGN::replay_file(path, threads, [&](int) {
+        return std::make_unique<ScanVisitor>(totals, check_san);
+    }, stats);
+    if (!opened) {
+        std::cout << "info string Cannot open " << path << std::endl;
+        return;
+    }
+
+    const double seconds = std::max(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), 1e-9);
+    std::cout << "Games: " << stats.games << " (" << stats.errors << " with errors)"
+              << "\nResults: +" << totals.results[0] << " -" << totals.results[1] << " =" << totals.results[2]
+              << " *" << totals.results[3]
+              << "\nPositions: " << stats.positions;
+    if (check_san) std::cout << "\nSAN mismatches: " << totals.san_mismatches;
+    std::cout << "\nPositions/second: " << static_cast<uint64_t>(stats.positions / seconds)
+              << "\nMB/second: " << static_cast<uint64_t>(stats.bytes / seconds / (1 << 20)) << std::endl;
+}
+
+} // namespace Games
+} // namespace aetherchess
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+
+namespace aetherchess {
+namespace Games {
+
+// Replays every game of a PGN file on 'threads' threads and reports games,
+// positions, results and throughput. With check_san, every move is also
+// formatted back to SAN and re-parsed to verify both conversions agree.
+void scan(const std::string& path, int threads, bool check_san);
+
+} // namespace Games
+} // namespace aetherchess
@@ -0,0 +1,306 @@
+#include "gensfen.h"
+#include "../io/dataset.h"
+#include "../io/training_record.h"
+#include "../movegen/movegen.h"
+#include "../search/search.h"
+#include "../tablebase/tablebase.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace aetherchess {
+namespace Gensfen {
+
+namespace {
+
+// Records per hand-off buffer.
+constexpr size_t BUFFER_RECORDS = 4096;
+// Buffers per producer thread: one being filled, the rest in flight.
+constexpr size_t BUFFERS_PER_THREAD = 4;
+
+using Buffer = std::vector<TrainingRecord>;
+
+// Single-producer single-consumer ring of buffer pointers. The producer only
+// writes 'tail' and the consumer only writes 'head', so neither side locks.
+class SpscRing {
+public:
+    bool push(Buffer* buffer) {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == BUFFERS_PER_THREAD) return false;
+        slots[t % BUFFERS_PER_THREAD] = buffer;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    Buffer* pop() {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return nullptr;
+        Buffer* buffer = slots[h % BUFFERS_PER_THREAD];
+        head.store(h + 1, std::memory_order_release);
+        return buffer;
+    }
+
+private:
+    std::array<Buffer*, BUFFERS_PER_THREAD> slots{};
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+};
+
+// The hand-off between one game thread and the writer: full buffers travel
+// to the writer on one ring and come back empty on the other.
+struct Channel {
+    Channel() {
+        for (Buffer& b : storage) {
+            b.reserve(BUFFER_RECORDS);
+            free.push(&b);
+        }
+    }
+
+    // Called by the producer; waits while the writer holds every buffer.
+    Buffer* acquire() {
+        Buffer* buffer;
+        while (!(buffer = free.pop())) std::this_thread::yield();
+        return buffer;
+    }
+
+    void submit(Buffer* buffer) {
+        while (!full.push(buffer)) std::this_thread::yield();
+    }
+
+    std::array<Buffer, BUFFERS_PER_THREAD> storage;
+    SpscRing full, free;
+};
+
+enum Outcome { MATE, STALEMATE, RULE_DRAW, TABLEBASE, RESIGN, DRAW_ADJUDICATED, MAX_PLY, OUTCOME_NB };
+
+struct Totals {
+    std::atomic<uint64_t> games{0};
+    std::atomic<uint64_t> results[3] = {}; // white wins, draws, black wins
+    std::atomic<uint64_t> outcomes[OUTCOME_NB] = {};
+};
+
+bool is_quiet(Move m) {
+    const MoveType type = Moves::get_type(m);
+    return type != CAPTURE && type != EN_PASSANT && type < PROMO_KNIGHT;
+}
+
+class GameThread {
+public:
+    GameThread(const Options& options, int id, Channel& channel, std::atomic<uint64_t>& recorded, Totals& totals)
+        : options(options), channel(channel), recorded(recorded), totals(totals),
+          rng(options.seed + 0x9E3779B97F4A7C15ULL * static_cast<uint64_t>(id + 1)) {
+        tt.resize(options.hash_mb);
+        worker = std::make_unique<Search::Worker>(tt);
+        pos = std::make_unique<Position>();
+    }
+
+    void run() {
+        Buffer* buffer = channel.acquire();
+        while (recorded.load(std::memory_order_relaxed) < options.count) {
+            play_game();
+            for (const TrainingRecord& r : game) {
+                buffer->push_back(r);
+                if (buffer->size() == BUFFER_RECORDS) {
+                    channel.submit(buffer);
+                    buffer = channel.acquire();
+                }
+            }
+            recorded += game.size();
+        }
+        channel.submit(buffer);
+    }
+
+private:
+    // Plays random legal moves. Returns false if the game ended on the way.
+    bool play_opening() {
+        for (int ply = 0; ply < options.random_plies; ++ply) {
+            MoveList list;
+            MoveGenerator::generate_moves(*pos, list);
+            Move legal[MAX_MOVES];
+            int count = 0;
+            for (int i = 0; i < list.count; ++i) {
+                if (pos->is_legal(list.moves[i])) legal[count++] = list.moves[i];
+            }
+            if (count == 0) return false;
+            pos->make_move(legal[std::uniform_int_distribution<int>(0, count - 1)(rng)]);
+        }
+        return !pos->is_draw(0);
+    }
+
+    // Plays one game and leaves its labeled positions in 'game'.
+    void play_game() {
+        game.clear();
+        do {
+            pos->set_from_fen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+        } while (!play_opening());
+        tt.clear();
+
+        Search::Limits limits;
+        limits.nodes = options.nodes;
+        int white_result = 0; // 1, 0, -1
+        Outcome outcome = MAX_PLY;
+        int resign_count = 0, draw_count = 0;
+        int last_score = 0;
+
+        for (int ply = options.random_plies; ply < options.max_ply; ++ply) {
+            if (pos->is_draw(0)) {
+                outcome = RULE_DRAW;
+                break;
+            }
+            const int pieces = BB::count_bits(pos->color_bbs[0] | pos->color_bbs[1]);
+            if (pieces <= Tablebase::max_pieces()) {
+                if (int wdl; Tablebase::probe_wdl(*pos, wdl)) {
+                    white_result = pos->side_to_move == Color::WHITE ? wdl : -wdl;
+                    outcome = TABLEBASE;
+                    break;
+                }
+            }
+
+            worker->stop = false;
+            tt.new_search();
+            const Search::Result result = worker->search(*pos, limits);
+            if (result.best_move == MOVE_NONE) {
+                outcome = pos->checkers() ? MATE : STALEMATE;
+                if (outcome == MATE) white_result = pos->side_to_move == Color::WHITE ? -1 : 1;
+                break;
+            }
+
+            const int score = result.score;
+            const bool mate_score = std::abs(score) >= Search::VALUE_MATE_IN_MAX_PLY;
+            if (!mate_score && !pos->checkers() && is_quiet(result.best_move)) {
+                TrainingRecord record{};
+                Packed::encode(*pos, record.pos);
+                record.score = static_cast<int16_t>(std::clamp(score, -32000, 32000));
+                record.ply = static_cast<uint16_t>(ply);
+                // The result is filled in once the game is over; side_to_move
+                // is kept in the sign of 'result' until then.
+                record.result = pos->side_to_move == Color::WHITE ? 1 : -1;
+                game.push_back(record);
+            }
+
+            // Adjudication. Both sides must agree on a lost position: the
+            // count runs over consecutive plies whose side-to-move scores
+            // alternate in sign, and restarts when one side disagrees.
+            const bool decisive = std::abs(score) >= options.resign_score;
+            const bool agrees = resign_count > 0 && (score > 0) != (last_score > 0);
+            resign_count = decisive ? (agrees ? resign_count + 1 : 1) : 0;
+            last_score = score;
+            if (resign_count >= options.resign_plies) {
+                const int stm_result = score > 0 ? 1 : -1;
+                white_result = pos->side_to_move == Color::WHITE ? stm_result : -stm_result;
+                outcome = RESIGN;
+                break;
+            }
+            draw_count = (ply >= options.draw_ply && std::abs(score) <= options.draw_score) ? draw_count + 1 : 0;
+            if (draw_count >= options.draw_plies) {
+                outcome = DRAW_ADJUDICATED;
+                break;
+            }
+
+            pos->make_move(result.best_move);
+            if (pos->history_ply >= 200) pos->compact_history();
+        }
+
+        for (TrainingRecord& r : game) r.result = static_cast<int8_t>(r.result * white_result);
+        ++totals.games;
+        ++totals.results[1 - white_result];
+        ++totals.outcomes[outcome];
+    }
+
+    const Options& options;
+    Channel& channel;
+    std::atomic<uint64_t>& recorded;
+    Totals& totals;
+    std::mt19937_64 rng;
+    TranspositionTable tt;
+    std::unique_ptr<Search::Worker> worker;
+    std::unique_ptr<Position> pos;
+    std::vector<TrainingRecord> game;
+};
+
+} // namespace
+
+void run(const Options& input_options) {
+    Options options = input_options;
+    options.threads = std::max(1, options.threads);
+    if (options.seed == 0) options.seed = std::random_device{}();
+
+    DatasetWriter<TrainingRecord> writer;
+    if (!writer.open(options.output_path)) {
+        std::cout << "info string Cannot create " << options.output_path << std::endl;
+        return;
+    }
+
+    std::vector<std::unique_ptr<Channel>> channels;
+    for (int t = 0; t < options.threads; ++t) channels.push_back(std::make_unique<Channel>());
+    std::atomic<uint64_t> recorded{0};
+    std::atomic<int> finished{0};
+    Totals totals;
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < options.threads; ++t) {
+        threads.emplace_back([&, t]() {
+            GameThread(options, t, *channels[t], recorded, totals).run();
+            finished.fetch_add(1, std::memory_order_release);
+        });
+    }
+
+    // The writer polls the channels. A buffer holds thousands of positions,
+    // so a millisecond of latency here costs nothing.
+    uint64_t written = 0;
+    auto last_report = start;
+    auto drain = [&]() {
+        bool any = false;
+        for (auto& channel : channels) {
+            while (Buffer* buffer = channel->full.pop()) {
+                const size_t n = std::min<uint64_t>(buffer->size(), options.count - written);
+                writer.write(std::span<const TrainingRecord>(buffer->data(), n));
+                written += n;
+                buffer->clear();
+                channel->free.push(buffer);
+                any = true;
+            }
+        }
+        return any;
+    };
+    while (true) {
+        const bool done = finished.load(std::memory_order_acquire) == options.threads;
+        if (!drain()) {
+            if (done) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        const auto now = std::chrono::steady_clock::now();
+        if (now - last_report >= std::chrono::seconds(10)) {
+            last_report = now;
+            const double seconds = std::chrono::duration<double>(now - start).count();
+            std::cout << "info string " << recorded << " positions, " << totals.games << " games, "
+                      << static_cast<uint64_t>(recorded / seconds) << " positions/s" << std::endl;
+        }
+    }
+    for (std::thread& t : threads) t.join();
+
+    if (!writer.close()) {
+        std::cout << "info string Write error on " << options.output_path << std::endl;
+        return;
+    }
+    const double seconds = std::max(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), 1e-9);
+    std::cout << "Games: " << totals.games << " (+" << totals.results[0] << " =" << totals.results[1] << " -"
+              << totals.results[2] << ")"
+              << "\nEndings: mate " << totals.outcomes[MATE] << ", stalemate " << totals.outcomes[STALEMATE]
+              << ", rule draw " << totals.outcomes[RULE_DRAW] << ", tablebase " << totals.outcomes[TABLEBASE]
+              << ", resign " << totals.outcomes[RESIGN] << ", adjudicated draw " << totals.outcomes[DRAW_ADJUDICATED]
+              << ", max ply " << totals.outcomes[MAX_PLY]
+              << "\nPositions: " << written << " written to " << options.output_path
+              << "\nPositions/second: " << static_cast<uint64_t>(written / seconds)
+              << "\nSeed: " << options.seed << std::endl;
+}
+
+} // namespace Gensfen
+} // namespace aetherchess
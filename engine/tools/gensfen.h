@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace aetherchess {
+namespace Gensfen {
+
+struct Options {
+    std::string output_path;
+    uint64_t count = 1000000;   // Positions to write.
+    int threads = 1;
+    uint64_t nodes = 5000;      // Per move.
+    int random_plies = 8;       // Uniformly random opening moves.
+    size_t hash_mb = 16;        // Per thread.
+    uint64_t seed = 0;          // 0 picks a random seed.
+
+    // Adjudication. A game is resigned once both sides have agreed on a score
+    // beyond resign_score for resign_plies consecutive plies, and drawn once
+    // the score stayed within draw_score for draw_plies plies after draw_ply.
+    int resign_score = 1000;
+    int resign_plies = 6;
+    int draw_score = 10;
+    int draw_plies = 10;
+    int draw_ply = 80;
+    int max_ply = 400;
+};
+
+// Plays fixed-node self-play games from random openings on 'threads' threads
+// and writes (position, score, result) TrainingRecords to a dataset file.
+// Only quiet positions are recorded: not in check, and with a best move that
+// is neither a capture nor a promotion.
+void run(const Options& options);
+
+} // namespace Gensfen
+} // namespace aetherchess
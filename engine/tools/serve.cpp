@@ -0,0 +1,502 @@
+#include "serve.h"
+#include "../io/json.h"
+#include "../movegen/movegen.h"
+#include "../perft.h"
+#include "../uci/uci.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace aetherchess {
+namespace Serve {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::string_view START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+double ms_between(Clock::time_point from, Clock::time_point to) {
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+// One client: stdin/stdout, or an accepted socket. Results of its requests
+// are written from the worker threads as they finish, one whole line at a time.
+class Connection {
+public:
+    // fd < 0 stands for stdin/stdout.
+    explicit Connection(int fd) : fd(fd) {}
+    ~Connection() {
+        if (fd >= 0) ::close(fd);
+    }
+
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    bool read_line(std::string& line) {
+        if (fd < 0) return static_cast<bool>(std::getline(std::cin, line));
+        while (true) {
+            if (const size_t nl = buffer.find('\n'); nl != std::string::npos) {
+                line.assign(buffer, 0, nl);
+                buffer.erase(0, nl + 1);
+                return true;
+            }
+            char chunk[4096];
+            const ssize_t n = ::read(fd, chunk, sizeof(chunk));
+            if (n <= 0) {
+                // The last line may lack its terminator.
+                line = std::move(buffer);
+                buffer.clear();
+                return !line.empty();
+            }
+            buffer.append(chunk, static_cast<size_t>(n));
+        }
+    }
+
+    void write_line(std::string line) {
+        line += '\n';
+        std::lock_guard<std::mutex> lock(write_mutex);
+        const int out = fd < 0 ? STDOUT_FILENO : fd;
+        for (size_t done = 0; done < line.size();) {
+            // A client that went away must not take the server down with SIGPIPE.
+            const ssize_t n = fd < 0 ? ::write(out, line.data() + done, line.size() - done)
+                                     : ::send(out, line.data() + done, line.size() - done, MSG_NOSIGNAL);
+            if (n <= 0) return;
+            done += static_cast<size_t>(n);
+        }
+    }
+
+    // Wakes a reader blocked on this connection.
+    void shutdown_read() {
+        if (fd >= 0) ::shutdown(fd, SHUT_RD);
+    }
+
+private:
+    int fd;
+    std::string buffer;
+    std::mutex write_mutex;
+};
+
+struct Request {
+    std::shared_ptr<Connection> connection;
+    std::string id = "null"; // Raw JSON, echoed back verbatim.
+    std::string fen{START_FEN};
+    std::vector<std::string> moves;
+    Search::Limits limits;
+    int multipv = 1;
+    Clock::time_point received;
+};
+
+// A fixed-capacity FIFO. push() blocks while it is full, which stops the
+// reader and, through the socket buffers, the client: that is the server's
+// backpressure.
+class RequestQueue {
+public:
+    explicit RequestQueue(size_t capacity) : capacity(std::max<size_t>(capacity, 1)) {}
+
+    bool push(Request&& request) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_full.wait(lock, [&] { return closed || queue.size() < capacity; });
+        if (closed) return false;
+        queue.push_back(std::move(request));
+        not_empty.notify_one();
+        return true;
+    }
+
+    // Returns false once the queue is closed and drained.
+    bool pop(Request& request) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_empty.wait(lock, [&] { return closed || !queue.empty(); });
+        if (queue.empty()) return false;
+        request = std::move(queue.front());
+        queue.pop_front();
+        not_full.notify_one();
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        not_empty.notify_all();
+        not_full.notify_all();
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return queue.size();
+    }
+
+private:
+    const size_t capacity;
+    std::mutex mutex;
+    std::condition_variable not_empty, not_full;
+    std::deque<Request> queue;
+    bool closed = false;
+};
+
+// Request counters and a window of recent latencies for the percentiles.
+class Metrics {
+public:
+    static constexpr size_t LATENCY_WINDOW = 4096;
+
+    void received() { ++received_count; }
+    void rejected() { ++failed_count; }
+
+    void finished(bool ok, uint64_t nodes, double latency_ms) {
+        (ok ? completed_count : failed_count)++;
+        total_nodes += nodes;
+        --in_flight_count;
+        std::lock_guard<std::mutex> lock(mutex);
+        if (latencies.size() < LATENCY_WINDOW) latencies.push_back(latency_ms);
+        else latencies[next_latency] = latency_ms;
+        next_latency = (next_latency + 1) % LATENCY_WINDOW;
+    }
+
+    void started() { ++in_flight_count; }
+
+    std::string to_json(size_t queued) {
+        std::vector<double> sorted;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            sorted = latencies;
+        }
+        std::sort(sorted.begin(), sorted.end());
+        auto percentile = [&](double p) {
+            // Nearest rank.
+            const size_t rank = static_cast<size_t>(std::ceil(p * static_cast<double>(sorted.size())));
+            return sorted.empty() ? 0.0 : sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+        };
+        double mean = 0;
+        for (const double l : sorted) mean += l;
+        if (!sorted.empty()) mean /= static_cast<double>(sorted.size());
+
+        const double uptime = std::max(ms_between(start, Clock::now()) / 1000, 1e-9);
+        std::ostringstream os;
+        os << std::fixed << std::setprecision(3) << "{\"uptime_s\": " << uptime
+           << ", \"received\": " << received_count << ", \"completed\": " << completed_count
+           << ", \"failed\": " << failed_count << ", \"queued\": " << queued
+           << ", \"in_flight\": " << in_flight_count << ", \"requests_per_s\": " << completed_count / uptime
+           << ", \"nodes\": " << total_nodes << ", \"nodes_per_s\": " << std::setprecision(0)
+           << total_nodes / uptime << std::setprecision(3) << ", \"latency_ms\": {\"window\": " << sorted.size()
+           << ", \"mean\": " << mean << ", \"p50\": " << percentile(0.5) << ", \"p90\": " << percentile(0.9)
+           << ", \"p99\": " << percentile(0.99) << ", \"max\": " << (sorted.empty() ? 0.0 : sorted.back())
+           << "}}";
+        return os.str();
+    }
+
+private:
+    const Clock::time_point start = Clock::now();
+    std::atomic<uint64_t> received_count{0}, completed_count{0}, failed_count{0};
+    std::atomic<uint64_t> total_nodes{0};
+    std::atomic<int> in_flight_count{0};
+    std::mutex mutex;
+    std::vector<double> latencies;
+    size_t next_latency = 0;
+};
+
+std::string error_reply(const std::string& id, const std::string& message) {
+    return "{\"id\": " + id + ", \"error\": " + Json::quote(message) + "}";
+}
+
+std::string score_to_json(int score) {
+    if (std::abs(score) >= Search::VALUE_MATE_IN_MAX_PLY) {
+        const int plies = Search::VALUE_MATE - std::abs(score);
+        return "{\"mate\": " + std::to_string(score > 0 ? (plies + 1) / 2 : -(plies + 1) / 2) + "}";
+    }
+    return "{\"cp\": " + std::to_string(score) + "}";
+}
+
+// Turns a request line into a Request. Returns false, with 'error' set, if
+// the line is not a valid request.
+bool parse_request(const Json::Object& object, const Search::Limits& defaults, Request& request,
+                   std::string& error) {
+    if (object.has("fen") && !object.get("fen", request.fen)) {
+        error = "\"fen\" must be a string";
+        return false;
+    }
+    if (object.has("moves") && !object.get("moves", request.moves)) {
+        // A single string of space-separated moves is accepted as well.
+        std::string moves;
+        if (!object.get("moves", moves)) {
+            error = "\"moves\" must be an array of strings";
+            return false;
+        }
+        std::istringstream is(moves);
+        for (std::string m; is >> m;) request.moves.push_back(m);
+    }
+
+    int64_t depth = 0, nodes = 0, movetime = 0, multipv = 1;
+    const bool has_depth = object.get("depth", depth);
+    const bool has_nodes = object.get("nodes", nodes);
+    const bool has_movetime = object.get("movetime", movetime);
+    if ((object.has("depth") && !has_depth) || (object.has("nodes") && !has_nodes) ||
+        (object.has("movetime") && !has_movetime) || (object.has("multipv") && !object.get("multipv", multipv))) {
+        error = "limits must be integers";
+        return false;
+    }
+    // A zero node or time limit would mean no limit at all, so every limit
+    // given must be at least 1.
+    if ((has_depth && depth < 1) || (has_nodes && nodes < 1) || (has_movetime && movetime < 1) || multipv < 1) {
+        error = "limits must be positive";
+        return false;
+    }
+
+    request.limits = Search::Limits{};
+    request.limits.move_overhead_ms = 0;
+    if (!has_depth && !has_nodes && !has_movetime) {
+        request.limits.depth = defaults.depth;
+        request.limits.nodes = defaults.nodes;
+        request.limits.movetime_ms = defaults.movetime_ms;
+    }
+    if (has_depth) request.limits.depth = static_cast<int>(std::min<int64_t>(depth, Search::MAX_PLY - 1));
+    if (has_nodes) request.limits.nodes = static_cast<uint64_t>(nodes);
+    if (has_movetime) request.limits.movetime_ms = movetime;
+    request.multipv = static_cast<int>(std::min<int64_t>(multipv, MAX_MOVES));
+    return true;
+}
+
+// Analyses one request on a worker. Returns the reply line and adds the
+// searched nodes to 'nodes'; 'ok' is false for an invalid position or move.
+std::string analyse(const Request& request, Position& pos, Search::Worker& worker, uint64_t& nodes, bool& ok) {
+    ok = false;
+    if (const FenResult fen = pos.set_from_fen(request.fen); !fen) {
+        return error_reply(request.id, "invalid FEN: " + std::string(fen_error_string(fen.error)));
+    }
+    for (const std::string& token : request.moves) {
+        const Move m = UCI::to_move(pos, token);
+        if (m == MOVE_NONE) return error_reply(request.id, "illegal move " + token);
+        pos.make_move(m);
+        if (pos.history_ply >= 200) pos.compact_history();
+    }
+    ok = true;
+
+    MoveList list;
+    MoveGenerator::generate_moves(pos, list);
+    std::vector<Move> remaining;
+    for (int i = 0; i < list.count; ++i) {
+        if (pos.is_legal(list.moves[i])) remaining.push_back(list.moves[i]);
+    }
+
+    // MultiPV: every further line searches the root moves that have not been
+    // reported yet. The limits apply to each line.
+    std::ostringstream lines;
+    Move best_move = MOVE_NONE;
+    Search::Limits limits = request.limits;
+    for (int k = 1; k <= request.multipv && !remaining.empty(); ++k) {
+        limits.search_moves = remaining;
+        worker.stop = false;
+        const Search::Result result = worker.search(pos, limits);
+        nodes += result.nodes;
+        if (result.best_move == MOVE_NONE) break;
+        if (k == 1) best_move = result.best_move;
+        remaining.erase(std::find(remaining.begin(), remaining.end(), result.best_move));
+
+        lines << (k > 1 ? ", " : "") << "{\"multipv\": " << k << ", \"score\": " << score_to_json(result.score)
+              << ", \"depth\": " << result.depth << ", \"nodes\": " << result.nodes << ", \"pv\": [";
+        for (size_t i = 0; i < result.pv.size(); ++i) {
+            lines << (i ? ", " : "") << "\"" << Perft::move_to_string(result.pv[i]) << "\"";
+        }
+        lines << "]}";
+    }
+
+    std::string reply = "{\"id\": " + request.id + ", \"bestmove\": ";
+    reply += best_move ? "\"" + Perft::move_to_string(best_move) + "\"" : "null";
+    if (!best_move) reply += pos.checkers() ? ", \"status\": \"checkmate\"" : ", \"status\": \"stalemate\"";
+    return reply + ", \"lines\": [" + lines.str() + "], \"nodes\": " + std::to_string(nodes);
+}
+
+class Server {
+public:
+    explicit Server(const Options& options) : options(options), queue(options.queue_size) {}
+
+    void start_workers() {
+        for (int t = 0; t < std::max(1, options.threads); ++t) workers.emplace_back([this] { worker_main(); });
+    }
+
+    // Drains the queue and waits for the workers.
+    void finish() {
+        queue.close();
+        for (std::thread& t : workers) t.join();
+    }
+
+    // Reads requests from a connection until it closes. Returns false if the
+    // client asked for a shutdown.
+    bool serve_connection(const std::shared_ptr<Connection>& connection) {
+        std::string line, error;
+        while (connection->read_line(line)) {
+            if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+            const Clock::time_point received = Clock::now();
+
+            Json::Object object;
+            if (!object.parse(line, error)) {
+                metrics.received();
+                metrics.rejected();
+                connection->write_line(error_reply("null", "bad request: " + error));
+                continue;
+            }
+            Request request;
+            if (const std::string_view id = object.raw("id"); !id.empty()) request.id = id;
+
+            std::string cmd;
+            if (object.get("cmd", cmd)) {
+                if (cmd == "stats") {
+                    connection->write_line("{\"id\": " + request.id + ", \"stats\": " + metrics.to_json(queue.size()) + "}");
+                } else if (cmd == "shutdown") {
+                    connection->write_line("{\"id\": " + request.id + ", \"status\": \"shutting down\"}");
+                    return false;
+                } else {
+                    connection->write_line(error_reply(request.id, "unknown command " + cmd));
+                }
+                continue;
+            }
+
+            metrics.received();
+            if (!parse_request(object, options.limits, request, error)) {
+                metrics.rejected();
+                connection->write_line(error_reply(request.id, error));
+                continue;
+            }
+            request.connection = connection;
+            request.received = received;
+            if (!queue.push(std::move(request))) break;
+        }
+        return true;
+    }
+
+private:
+    void worker_main() {
+        TranspositionTable tt;
+        tt.resize(options.hash_mb);
+        auto worker = std::make_unique<Search::Worker>(tt);
+        auto pos = std::make_unique<Position>();
+
+        Request request;
+        while (queue.pop(request)) {
+            const Clock::time_point dequeued = Clock::now();
+            metrics.started();
+            uint64_t nodes = 0;
+            bool ok;
+            tt.new_search();
+            std::string reply = analyse(request, *pos, *worker, nodes, ok);
+            const Clock::time_point done = Clock::now();
+            const double latency = ms_between(request.received, done);
+            metrics.finished(ok, nodes, latency);
+
+            if (ok) {
+                std::ostringstream timing;
+                timing << std::fixed << std::setprecision(3) << ", \"queue_ms\": " << ms_between(request.received, dequeued)
+                       << ", \"search_ms\": " << ms_between(dequeued, done) << ", \"latency_ms\": " << latency << "}";
+                reply += timing.str();
+            }
+            request.connection->write_line(std::move(reply));
+            request.connection.reset();
+        }
+    }
+
+    const Options options;
+    RequestQueue queue;
+    Metrics metrics;
+    std::vector<std::thread> workers;
+};
+
+// Accepts clients on a Unix socket, each served by its own detached reader
+// thread, until one of them asks for a shutdown. Failed accepts (too many
+// open files, aborted connections) are logged and retried.
+void serve_socket(Server& server, const std::string& path) {
+    const int listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (listen_fd < 0 || path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Cannot create socket " << path << std::endl;
+        if (listen_fd >= 0) ::close(listen_fd);
+        return;
+    }
+    std::copy(path.begin(), path.end(), address.sun_path);
+    ::unlink(path.c_str());
+    if (::bind(listen_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(listen_fd, 64) != 0) {
+        std::cerr << "Cannot listen on " << path << std::endl;
+        ::close(listen_fd);
+        return;
+    }
+    std::cerr << "Listening on " << path << std::endl;
+
+    // Guards clients and active_readers; readers_done is signalled when the
+    // last reader finishes.
+    std::mutex clients_mutex;
+    std::condition_variable readers_done;
+    std::vector<std::weak_ptr<Connection>> clients;
+    int active_readers = 0;
+    std::atomic<bool> stopping{false};
+
+    while (!stopping) {
+        const int fd = ::accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            const int err = errno;
+            if (stopping || err == EINTR) continue;
+            std::cerr << "accept on " << path << " failed: " << std::strerror(err) << std::endl;
+            // Out of descriptors: give the readers a moment to close some.
+            if (err == EMFILE || err == ENFILE) std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            continue;
+        }
+        auto connection = std::make_shared<Connection>(fd);
+        {
+            std::lock_guard<std::mutex> lock(clients_mutex);
+            clients.erase(std::remove_if(clients.begin(), clients.end(),
+                                         [](const std::weak_ptr<Connection>& c) { return c.expired(); }),
+                          clients.end());
+            clients.push_back(connection);
+            ++active_readers;
+        }
+        std::thread([&, connection]() mutable {
+            if (!server.serve_connection(connection)) {
+                // Shutdown: wake the accept loop and every other reader.
+                stopping = true;
+                ::shutdown(listen_fd, SHUT_RDWR);
+                std::lock_guard<std::mutex> lock(clients_mutex);
+                for (const auto& client : clients) {
+                    if (const auto c = client.lock()) c->shutdown_read();
+                }
+            }
+            connection.reset();
+            std::lock_guard<std::mutex> lock(clients_mutex);
+            if (--active_readers == 0) readers_done.notify_all();
+        }).detach();
+    }
+    {
+        std::unique_lock<std::mutex> lock(clients_mutex);
+        readers_done.wait(lock, [&] { return active_readers == 0; });
+    }
+    ::close(listen_fd);
+    ::unlink(path.c_str());
+}
+
+} // namespace
+
+void run(const Options& options) {
+    std::cout.flush();
+    Server server(options);
+    server.start_workers();
+    if (options.socket_path.empty()) server.serve_connection(std::make_shared<Connection>(-1));
+    else serve_socket(server, options.socket_path);
+    server.finish();
+}
+
+} // namespace Serve
+} // namespace aetherchess
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "../search/search.h"
+#include <cstddef>
+#include <string>
+
+namespace aetherchess {
+namespace Serve {
+
+// Batch analysis server. Requests are JSON objects, one per line:
+//
+//   {"id": 7, "fen": "<fen>", "moves": ["e2e4", "e7e5"], "depth": 12,
+//    "nodes": 1000000, "movetime": 500, "multipv": 3}
+//
+// Every member but "id" is optional; the position defaults to the start
+// position and the limits to Options::limits. Results are written as one JSON
+// line per request, tagged with its id, in the order they finish:
+//
+//   {"id": 7, "bestmove": "g1f3", "lines": [{"multipv": 1, "score": {"cp": 31},
+//    "depth": 12, "nodes": 80012, "pv": ["g1f3", ...]}, ...], "nodes": ...,
+//    "queue_ms": 0.1, "search_ms": 41.5, "latency_ms": 41.6}
+//
+// {"cmd": "stats"} answers immediately with the request counters, throughput
+// and latency percentiles; {"cmd": "shutdown"} stops a socket server.
+struct Options {
+    int threads = 1;
+    size_t queue_size = 64;  // Requests waiting for a worker before readers block.
+    size_t hash_mb = 16;     // Per worker.
+    std::string socket_path; // Listen on this Unix socket instead of stdin/stdout.
+    Search::Limits limits;   // Used for requests that set no limit.
+};
+
+// Serves requests until stdin is exhausted, or until a client sends
+// {"cmd": "shutdown"} in socket mode. Requests already accepted are answered
+// before returning.
+void run(const Options& options);
+
+} // namespace Serve
+} // namespace aetherchess
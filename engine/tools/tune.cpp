@@ -0,0 +1,319 @@
+#include "tune.h"
+#include "../eval/eval.h"
+#include "../eval/eval_params.h"
+#include "../io/dataset.h"
+#include "../io/training_record.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace aetherchess {
+namespace Tune {
+
+namespace {
+
+// Parameter layout: the six piece-square tables (index pt * 64 + square),
+// then the material values of pawn to queen. The king's value is not tuned;
+// both sides always have exactly one.
+constexpr int PST_PARAMS = 6 * 64;
+constexpr int MATERIAL_PARAMS = 5;
+constexpr int PARAM_COUNT = PST_PARAMS + MATERIAL_PARAMS;
+
+// Features index a table of piece values: pt * 64 + table square for a white
+// piece, 384 more for a black one, whose entries are negated. The evaluation
+// of a position is then the plain sum of its entries.
+constexpr int FEATURE_COUNT = 2 * PST_PARAMS;
+
+// The positions of one thread, reduced to features, one per piece, and the
+// activity score, which is not tuned.
+struct Shard {
+    std::vector<uint16_t> features;
+    std::vector<uint32_t> offsets{0}; // Feature range of position i: [offsets[i], offsets[i + 1]).
+    std::vector<float> activity;      // Activity terms from white's point of view.
+    std::vector<float> results;       // From white's point of view: 1, 0.5 or 0.
+    std::vector<float> scores;        // Search score from white's point of view.
+    std::vector<float> targets;
+
+    size_t size() const { return results.size(); }
+};
+
+// Returns false, adding nothing, if the record does not decode.
+bool extract(const TrainingRecord& record, Shard& shard, Position& pos) {
+    if (!Packed::decode(record.pos, pos)) return false;
+    const int activity = Eval::evaluate_activity(pos);
+    shard.activity.push_back(static_cast<float>(pos.side_to_move == Color::WHITE ? activity : -activity));
+
+    Bitboard occupied = record.pos.occupancy;
+    for (int i = 0; occupied; ++i) {
+        const int s = BB::pop_lsb(occupied);
+        const int code = (record.pos.pieces[i / 2] >> ((i & 1) * 4)) & 0xF;
+        const int pt = code & 0x7;
+        const bool black = code >> 3;
+        if (pt > static_cast<int>(PieceType::KING)) continue;
+        const int feature = (black ? PST_PARAMS : 0) + pt * 64 + (black ? s ^ 56 : s);
+        shard.features.push_back(static_cast<uint16_t>(feature));
+    }
+    shard.offsets.push_back(static_cast<uint32_t>(shard.features.size()));
+
+    const bool black_to_move = record.pos.side_castling & 0x80;
+    const float result = static_cast<float>(record.result) * (black_to_move ? -1.0f : 1.0f);
+    shard.results.push_back(0.5f + 0.5f * result);
+    shard.scores.push_back(static_cast<float>(black_to_move ? -record.score : record.score));
+    return true;
+}
+
+// Folds the parameters into the feature table.
+std::vector<float> feature_values(const std::vector<double>& params) {
+    std::vector<float> values(FEATURE_COUNT);
+    for (int index = 0; index < PST_PARAMS; ++index) {
+        const int pt = index / 64;
+        const double value = params[index] + (pt < MATERIAL_PARAMS ? params[PST_PARAMS + pt] : 0.0);
+        values[index] = static_cast<float>(value);
+        values[PST_PARAMS + index] = static_cast<float>(-value);
+    }
+    return values;
+}
+
+float evaluate(const Shard& shard, size_t i, const float* values) {
+    float e = shard.activity[i];
+    for (uint32_t f = shard.offsets[i]; f < shard.offsets[i + 1]; ++f) e += values[shard.features[f]];
+    return e;
+}
+
+double sigmoid(double k, double e) {
+    return 1.0 / (1.0 + std::exp(-k * e / 400.0));
+}
+
+// Runs f(thread_index) on one thread per shard.
+template <typename F>
+void parallel(size_t threads, F&& f) {
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < threads; ++t) pool.emplace_back([&f, t]() { f(t); });
+    for (std::thread& th : pool) th.join();
+}
+
+// Mean squared error of the evaluations against the results alone.
+double result_loss(const std::vector<Shard>& shards, const std::vector<std::vector<float>>& evals, double k) {
+    std::vector<double> sums(shards.size());
+    parallel(shards.size(), [&](size_t t) {
+        double sum = 0;
+        for (size_t i = 0; i < shards[t].size(); ++i) {
+            const double d = shards[t].results[i] - sigmoid(k, evals[t][i]);
+            sum += d * d;
+        }
+        sums[t] = sum;
+    });
+    size_t n = 0;
+    for (const Shard& s : shards) n += s.size();
+    double total = 0;
+    for (const double s : sums) total += s;
+    return total / static_cast<double>(std::max<size_t>(n, 1));
+}
+
+// Golden-section search for the K that best maps the current evaluation to
+// game results. The evaluations do not depend on K, so they are computed once.
+double fit_k(const std::vector<Shard>& shards, const std::vector<double>& params) {
+    const std::vector<float> values = feature_values(params);
+    std::vector<std::vector<float>> evals(shards.size());
+    parallel(shards.size(), [&](size_t t) {
+        evals[t].resize(shards[t].size());
+        for (size_t i = 0; i < shards[t].size(); ++i) evals[t][i] = evaluate(shards[t], i, values.data());
+    });
+
+    const double phi = (std::sqrt(5.0) - 1) / 2;
+    double lo = 0.05, hi = 5.0;
+    double a = hi - phi * (hi - lo), b = lo + phi * (hi - lo);
+    double la = result_loss(shards, evals, a), lb = result_loss(shards, evals, b);
+    for (int i = 0; i < 40; ++i) {
+        if (la < lb) {
+            hi = b;
+            b = a;
+            lb = la;
+            a = hi - phi * (hi - lo);
+            la = result_loss(shards, evals, a);
+        } else {
+            lo = a;
+            a = b;
+            la = lb;
+            b = lo + phi * (hi - lo);
+            lb = result_loss(shards, evals, b);
+        }
+    }
+    return (lo + hi) / 2;
+}
+
+// Returns the loss and fills 'gradient' with its derivative by every parameter.
+double loss_and_gradient(const std::vector<Shard>& shards, const std::vector<double>& params, double k,
+                         std::vector<double>& gradient) {
+    const std::vector<float> values = feature_values(params);
+    // Per thread, the derivative by every feature; folded into the parameters below.
+    std::vector<std::vector<double>> grads(shards.size(), std::vector<double>(FEATURE_COUNT));
+    std::vector<double> sums(shards.size());
+    parallel(shards.size(), [&](size_t t) {
+        const Shard& shard = shards[t];
+        double* const g = grads[t].data();
+        double sum = 0;
+        for (size_t i = 0; i < shard.size(); ++i) {
+            const double s = sigmoid(k, evaluate(shard, i, values.data()));
+            const double d = shard.targets[i] - s;
+            sum += d * d;
+            // d/de of (target - sigmoid(k e / 400))^2
+            const double de = -2.0 * d * s * (1.0 - s) * k / 400.0;
+            for (uint32_t f = shard.offsets[i]; f < shard.offsets[i + 1]; ++f) g[shard.features[f]] += de;
+        }
+        sums[t] = sum;
+    });
+
+    size_t n = 0;
+    for (const Shard& s : shards) n += s.size();
+    const double scale = 1.0 / static_cast<double>(std::max<size_t>(n, 1));
+    gradient.assign(PARAM_COUNT, 0.0);
+    double total = 0;
+    for (size_t t = 0; t < shards.size(); ++t) {
+        total += sums[t];
+        for (int index = 0; index < PST_PARAMS; ++index) {
+            const double d = (grads[t][index] - grads[t][PST_PARAMS + index]) * scale;
+            gradient[index] += d;
+            if (index / 64 < MATERIAL_PARAMS) gradient[PST_PARAMS + index / 64] += d;
+        }
+    }
+    return total * scale;
+}
+
+bool write_header(const std::string& path, const std::vector<double>& params, const std::string& comment) {
+    static const char* const names[6] = {"pawn_pst", "knight_pst", "bishop_pst",
+                                         "rook_pst", "queen_pst", "king_pst"};
+    std::ofstream out(path);
+    out << "#pragma once\n\n"
+        << "// Evaluation parameters, in centipawns. The \"tune\" command writes a file in\n"
+        << "// this format; copy it over this one to use the tuned values.\n"
+        << "// " << comment << "\n\n"
+        << "namespace aetherchess {\nnamespace Eval {\n\n"
+        << "// Piece-Square Tables (PSTs)\n"
+        << "// These tables score a piece based on its position on the board.\n"
+        << "// The values are in centipawns. They are defined from white's perspective.\n"
+        << "// For black, the square index is flipped.\n";
+    for (int pt = 0; pt < 6; ++pt) {
+        out << "\nconstexpr int " << names[pt] << "[64] = {\n";
+        for (int s = 0; s < 64; ++s) {
+            out << (s % 8 == 0 ? "    " : "") << std::setw(3) << std::lround(params[pt * 64 + s])
+                << (s == 63 ? "\n" : s % 8 == 7 ? ",\n" : ",");
+        }
+        out << "};\n";
+    }
+    out << "\nconstexpr int material_values[6] = {";
+    for (int pt = 0; pt < MATERIAL_PARAMS; ++pt) out << std::lround(params[PST_PARAMS + pt]) << ", ";
+    out << Eval::material_values[5] << "}; // PAWN to KING\n\n";
+
+    // The activity terms are not tuned; keep them.
+    auto write_array = [&out](const char* name, const int (&values)[6]) {
+        out << "constexpr int " << name << "[6] = {";
+        for (int pt = 0; pt < 6; ++pt) out << values[pt] << (pt < 5 ? ", " : "}; // PAWN to KING\n");
+    };
+    out << "// Piece activity, scored from the attack maps. Not tuned by \"tune\", which\n"
+        << "// copies these values through unchanged.\n\n"
+        << "// Mobility bonus per square a piece type attacks that is neither occupied by\n"
+        << "// an own piece nor attacked by an enemy pawn.\n";
+    write_array("mobility_weights", Eval::mobility_weights);
+    out << "\n// Bonus per square around the enemy king attacked by a piece type.\n";
+    write_array("king_attack_weights", Eval::king_attack_weights);
+    out << "\n// Penalty for a knight, bishop, rook or queen that is attacked and undefended.\n"
+        << "constexpr int hanging_piece_penalty = " << Eval::hanging_piece_penalty << ";\n"
+        << "\n} // namespace Eval\n} // namespace aetherchess\n";
+    return static_cast<bool>(out);
+}
+
+} // namespace
+
+void run(const Options& options) {
+    DatasetReader<TrainingRecord> reader;
+    std::string error;
+    if (!reader.open(options.dataset_path, error)) {
+        std::cout << "info string " << error << std::endl;
+        return;
+    }
+    const size_t threads = std::clamp<size_t>(static_cast<size_t>(std::max(1, options.threads)), 1,
+                                              std::max<size_t>(1, reader.size()));
+
+    const auto start = std::chrono::steady_clock::now();
+    auto seconds_since = [](std::chrono::steady_clock::time_point t) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - t).count();
+    };
+
+    // Feature extraction, once, each thread into its own shard.
+    std::vector<Shard> shards(threads);
+    parallel(threads, [&](size_t t) {
+        const std::span<const TrainingRecord> slice = reader.shard(t, threads);
+        Shard& shard = shards[t];
+        shard.features.reserve(slice.size() * 26);
+        shard.activity.reserve(slice.size());
+        shard.results.reserve(slice.size());
+        shard.scores.reserve(slice.size());
+        auto pos = std::make_unique<Position>();
+        for (const TrainingRecord& record : slice) extract(record, shard, *pos);
+    });
+    size_t positions = 0;
+    for (const Shard& shard : shards) positions += shard.size();
+    if (positions < reader.size()) {
+        std::cout << "Skipped " << reader.size() - positions << " records that do not decode" << std::endl;
+    }
+    std::cout << "Loaded " << positions << " positions in " << std::fixed << std::setprecision(2)
+              << seconds_since(start) << " s" << std::endl;
+
+    std::vector<double> params(PARAM_COUNT);
+    const int* const psts[6] = {Eval::pawn_pst, Eval::knight_pst, Eval::bishop_pst,
+                                Eval::rook_pst, Eval::queen_pst, Eval::king_pst};
+    for (int pt = 0; pt < 6; ++pt) {
+        for (int s = 0; s < 64; ++s) params[pt * 64 + s] = psts[pt][s];
+    }
+    for (int pt = 0; pt < MATERIAL_PARAMS; ++pt) params[PST_PARAMS + pt] = Eval::material_values[pt];
+
+    const double k = fit_k(shards, params);
+    for (Shard& shard : shards) {
+        shard.targets.resize(shard.size());
+        for (size_t i = 0; i < shard.size(); ++i) {
+            shard.targets[i] = static_cast<float>(options.lambda * shard.results[i] +
+                                                  (1 - options.lambda) * sigmoid(k, shard.scores[i]));
+        }
+    }
+    std::cout << "K: " << std::setprecision(4) << k << std::endl;
+
+    // Adam.
+    constexpr double beta1 = 0.9, beta2 = 0.999, epsilon = 1e-8;
+    std::vector<double> m(PARAM_COUNT), v(PARAM_COUNT), gradient;
+    double loss = 0;
+    const auto tuning_start = std::chrono::steady_clock::now();
+    for (int epoch = 1; epoch <= options.epochs; ++epoch) {
+        loss = loss_and_gradient(shards, params, k, gradient);
+        const double c1 = 1 - std::pow(beta1, epoch), c2 = 1 - std::pow(beta2, epoch);
+        for (int p = 0; p < PARAM_COUNT; ++p) {
+            m[p] = beta1 * m[p] + (1 - beta1) * gradient[p];
+            v[p] = beta2 * v[p] + (1 - beta2) * gradient[p] * gradient[p];
+            params[p] -= options.learning_rate * (m[p] / c1) / (std::sqrt(v[p] / c2) + epsilon);
+        }
+        if (epoch == 1 || epoch % 10 == 0 || epoch == options.epochs) {
+            std::cout << "Epoch " << epoch << " loss " << std::setprecision(6) << loss << " ("
+                      << std::setprecision(3) << seconds_since(tuning_start) / epoch << " s/epoch)" << std::endl;
+        }
+    }
+
+    std::ostringstream comment;
+    comment << "Tuned on " << positions << " positions, " << options.epochs << " epochs, K "
+            << std::setprecision(4) << k << ", lambda " << options.lambda << ", loss "
+            << std::setprecision(6) << loss << ".";
+    if (!write_header(options.output_path, params, comment.str())) {
+        std::cout << "info string Cannot write " << options.output_path << std::endl;
+        return;
+    }
+    std::cout << "Wrote " << options.output_path << std::defaultfloat << std::endl;
+}
+
+} // namespace Tune
+} // namespace aetherchess
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+
+namespace aetherchess {
+namespace Tune {
+
+struct Options {
+    std::string dataset_path; // TrainingRecords, as written by gensfen.
+    std::string output_path = "eval_params.h";
+    int threads = 1;
+    int epochs = 100;
+    double learning_rate = 1.0; // Centipawns per step.
+    // Weight of the game result in the target; the rest is the search score.
+    double lambda = 1.0;
+};
+
+// Texel tuning of the evaluation parameters (material values and piece-square
+// tables). The dataset is loaded once and every position is reduced to its
+// evaluation feature list, so an epoch is a parallel sweep over small integer
+// arrays. The scaling constant K of the sigmoid is fitted to the current
+// parameters first, then full-batch Adam minimises the mean squared error
+// between sigmoid(K * eval / 400) and the target. The result is written as a
+// header in the format of eval/eval_params.h. The activity terms (mobility,
+// king-zone attacks, hanging pieces) are not tuned: each position's activity
+// score is computed once and added to its evaluation as a fixed offset, and
+// the weights are written through unchanged.
+void run(const Options& options);
+
+} // namespace Tune
+} // namespace aetherchess
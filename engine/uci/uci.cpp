@@ -0,0 +1,732 @@
+#include "uci.h"
+#include "../book/opening_tree.h"
+#include "../book/polyglot.h"
+#include "../core/stats.h"
+#include "../movegen/attacks.h"
+#include "../movegen/movegen.h"
+#include "../perft.h"
+#include "../io/mapped_file.h"
+#include "../search/mate.h"
+#include "../search/search.h"
+#include "../tablebase/tablebase.h"
+#include "../tools/dataset.h"
+#include "../tools/epd.h"
+#include "../tools/games.h"
+#include "../tools/gensfen.h"
+#include "../tools/serve.h"
+#include "../tools/tune.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace aetherchess {
+namespace UCI {
+
+static const std::string START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+Move to_move(const Position& pos, const std::string& str) {
+    if (str.size() < 4 || str.size() > 5) return MOVE_NONE;
+    if (str[0] < 'a' || str[0] > 'h' || str[1] < '1' || str[1] > '8' ||
+        str[2] < 'a' || str[2] > 'h' || str[3] < '1' || str[3] > '8') {
+        return MOVE_NONE;
+    }
+
+    const Square from = static_cast<Square>((str[1] - '1') * 8 + (str[0] - 'a'));
+    const Square to = static_cast<Square>((str[3] - '1') * 8 + (str[2] - 'a'));
+    const PieceType pt = pos.piece_on_sq[from];
+    const bool is_capture = pos.color_on_sq[to] != Color::NONE;
+
+    MoveType type = is_capture ? CAPTURE : QUIET;
+    if (str.size() == 5) {
+        int promo;
+        switch (str[4]) {
+            case 'n': promo = PROMO_KNIGHT; break;
+            case 'b': promo = PROMO_BISHOP; break;
+            case 'r': promo = PROMO_ROOK; break;
+            case 'q': promo = PROMO_QUEEN; break;
+            default: return MOVE_NONE;
+        }
+        type = static_cast<MoveType>(is_capture ? promo + 4 : promo);
+    } else if (pt == PieceType::PAWN && to == pos.en_passant_sq && (to - from) % 8 != 0) {
+        type = EN_PASSANT;
+    } else if (pt == PieceType::PAWN && (to - from == 16 || from - to == 16)) {
+        type = DOUBLE_PAWN_PUSH;
+    } else if (pt == PieceType::KING && to - from == 2) {
+        type = KING_CASTLE;
+    } else if (pt == PieceType::KING && from - to == 2) {
+        type = QUEEN_CASTLE;
+    }
+
+    const Move m = Moves::create(from, to, type);
+    return (pos.is_pseudo_legal(m) && pos.is_legal(m)) ? m : MOVE_NONE;
+}
+
+// position [startpos | fen <fen>] [moves <m1> ... <mn>]
+static void handle_position(Position& pos, std::istringstream& is) {
+    std::string token, fen;
+    is >> token;
+    if (token == "startpos") {
+        fen = START_FEN;
+        is >> token; // Consume "moves" if present
+    } else if (token == "fen") {
+        while (is >> token && token != "moves") fen += token + " ";
+    } else {
+        return;
+    }
+    if (const FenResult result = pos.set_from_fen(fen); !result) {
+        std::cout << "info string Invalid FEN at offset " << result.offset << ": "
+                  << fen_error_string(result.error) << std::endl;
+        pos.set_from_fen(START_FEN);
+        return;
+    }
+
+    // Replay the game moves. The history is compacted after each one so that
+    // repetitions across the whole game stay detectable however long it is.
+    while (is >> token) {
+        const Move m = to_move(pos, token);
+        if (m == MOVE_NONE) {
+            std::cout << "info string Illegal move " << token << std::endl;
+            break;
+        }
+        pos.make_move(m);
+        pos.compact_history();
+    }
+}
+
+// State shared by the commands of one UCI session.
+struct Session {
+    Position pos;
+    TranspositionTable tt;
+    size_t hash_mb = 16;
+    int64_t move_overhead_ms = 10;
+    std::unique_ptr<Search::Worker> worker;
+    // "go mate" solver; its table is allocated on first use, MateHash MB
+    // large, and released on ucinewgame and Hash changes.
+    Mate::Solver mate_solver;
+    size_t mate_hash_mb = 16;
+    std::unique_ptr<Position> search_pos;
+    std::thread search_thread;
+    Polyglot::Book book;
+    std::mt19937_64 book_rng{std::random_device{}()};
+    // Counters of the last search or perft run (empty unless built with
+    // AETHERCHESS_STATS).
+    Stats::Counters stats;
+
+    Session() {
+        tt.resize(hash_mb);
+        worker = std::make_unique<Search::Worker>(tt);
+        pos.set_from_fen(START_FEN);
+    }
+
+    // Stops a running search and waits for its bestmove to be printed.
+    void wait_for_search(bool stop) {
+        if (!search_thread.joinable()) return;
+        if (stop) worker->stop = mate_solver.stop = true;
+        search_thread.join();
+    }
+};
+
+static void print_iteration(const Search::IterationInfo& info) {
+    std::cout << "info depth " << info.depth << " score " << Search::score_to_uci(info.score)
+              << " nodes " << info.nodes << " nps " << info.nodes * 1000 / std::max<int64_t>(info.time_ms, 1)
+              << " time " << info.time_ms << " pv";
+    for (Move m : info.pv) std::cout << " " << Perft::move_to_string(m);
+    std::cout << std::endl;
+}
+
+// Runs the mate solver on its own copy of the position, like a search, and
+// reports the mating line as a one-iteration search would.
+static void start_mate_solve(Session& session, const Mate::Limits& limits) {
+    if (session.mate_solver.table_mb() != session.mate_hash_mb) {
+        try {
+            session.mate_solver.resize(session.mate_hash_mb);
+        } catch (const std::bad_alloc&) {
+            std::cout << "info string Cannot allocate the mate solver's table" << std::endl;
+            std::cout << "bestmove 0000" << std::endl;
+            return;
+        }
+    }
+    session.search_pos = std::make_unique<Position>(session.pos);
+    session.mate_solver.stop = false;
+    session.worker->stop = false;
+    session.search_thread = std::thread([&session, limits]() {
+        const Mate::Result result = session.mate_solver.solve(*session.search_pos, limits);
+        const uint64_t nps = result.nodes * 1000 / static_cast<uint64_t>(std::max<int64_t>(result.time_ms, 1));
+        if (result.outcome == Mate::Outcome::MATE) {
+            std::cout << "info depth " << result.length << " score mate " << (result.length + 1) / 2
+                      << " nodes " << result.nodes << " nps " << nps << " time " << result.time_ms << " pv";
+            for (Move m : result.line) std::cout << " " << Perft::move_to_string(m);
+            std::cout << std::endl;
+        } else {
+            std::cout << "info nodes " << result.nodes << " nps " << nps << " time " << result.time_ms
+                      << std::endl;
+            if (result.outcome == Mate::Outcome::NO_MATE) {
+                std::cout << "info string No mate in " << limits.moves << std::endl;
+            } else {
+                std::cout << "info string Mate search stopped" << std::endl;
+            }
+        }
+        // Without a mate, a shallow search supplies the move; it always
+        // completes its first iteration, even when stopped, so it only
+        // returns no move if there is no legal one.
+        Move best_move = result.line.empty() ? MOVE_NONE : result.line[0];
+        if (best_move == MOVE_NONE) {
+            Search::Limits fallback;
+            fallback.depth = 6;
+            session.tt.new_search();
+            best_move = session.worker->search(*session.search_pos, fallback).best_move;
+        }
+        std::cout << "bestmove " << (best_move ? Perft::move_to_string(best_move) : "0000") << std::endl;
+    });
+}
+
+// go perft <depth> | go mate <moves> [nodes <n>] [movetime <ms>]
+// go [depth <d>] [nodes <n>] [movetime <ms>] [wtime <ms>] [btime <ms>]
+//    [winc <ms>] [binc <ms>] [movestogo <n>] [searchmoves <move>...] [infinite]
+static void handle_go(Session& session, std::istringstream& is) {
+    Search::Limits limits;
+    int mate_moves = 0;
+    std::string token;
+    bool in_search_moves = false;
+    while (is >> token) {
+        if (in_search_moves) {
+            if (const Move m = to_move(session.pos, token); m != MOVE_NONE) {
+                limits.search_moves.push_back(m);
+                continue;
+            }
+            in_search_moves = false;
+        }
+        if (token == "searchmoves") in_search_moves = true;
+        else if (token == "perft") {
+            int depth = 1;
+            is >> depth;
+
+            Position& pos = session.pos;
+            Stats::take();
+            MoveList move_list;
+            MoveGenerator::generate_moves(pos, move_list);
+            uint64_t total = 0;
+            for (int i = 0; i < move_list.count; ++i) {
+                const Move m = move_list.moves[i];
+                if (!pos.make_move(m)) continue;
+                const uint64_t nodes = Perft::run(pos, depth - 1);
+                pos.unmake_move(m);
+                total += nodes;
+                std::cout << Perft::move_to_string(m) << ": " << nodes << std::endl;
+            }
+            std::cout << "\nNodes searched: " << total << std::endl;
+            session.stats = Stats::take();
+            if (Stats::ENABLED) Stats::print_info(std::cout, session.stats);
+            return;
+        }
+        if (token == "depth") is >> limits.depth;
+        else if (token == "nodes") is >> limits.nodes;
+        else if (token == "movetime") is >> limits.movetime_ms;
+        else if (token == "wtime") is >> limits.wtime_ms;
+        else if (token == "btime") is >> limits.btime_ms;
+        else if (token == "winc") is >> limits.winc_ms;
+        else if (token == "binc") is >> limits.binc_ms;
+        else if (token == "movestogo") is >> limits.movestogo;
+        else if (token == "mate") is >> mate_moves;
+        else if (token == "infinite") limits.infinite = true;
+    }
+    limits.move_overhead_ms = session.move_overhead_ms;
+
+    if (mate_moves > 0) {
+        start_mate_solve(session, {mate_moves, limits.nodes, limits.movetime_ms});
+        return;
+    }
+
+    if (const Move book_move = session.book.pick(session.pos, session.book_rng); book_move != MOVE_NONE) {
+        std::cout << "bestmove " << Perft::move_to_string(book_move) << std::endl;
+        return;
+    }
+
+    // The search runs on its own copy of the position so that the session can
+    // keep reading commands (notably "stop") meanwhile.
+    session.search_pos = std::make_unique<Position>(session.pos);
+    session.worker->stop = false;
+    session.tt.new_search();
+    session.search_thread = std::thread([&session, limits]() {
+        const Search::Result result = session.worker->search(*session.search_pos, limits, print_iteration);
+        // UCI forbids a bestmove before "stop" in infinite mode, even when
+        // the search has run out of depth.
+        while (limits.infinite && !session.worker->stop) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        session.stats = Stats::take();
+        if (Stats::ENABLED) Stats::print_info(std::cout, session.stats);
+        std::cout << "bestmove " << (result.best_move ? Perft::move_to_string(result.best_move) : "0000") << std::endl;
+    });
+}
+
+// serve [threads <t>] [queue <n>] [hash <mb>] [depth <d>] [socket <path>]
+// Answers JSON-lines analysis requests until stdin ends, or on a Unix socket
+// until a client sends a shutdown command.
+static void handle_serve(std::istringstream& is) {
+    Serve::Options options;
+    options.threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    options.limits.depth = 10;
+    std::string token;
+    while (is >> token) {
+        if (token == "threads") is >> options.threads;
+        else if (token == "queue") is >> options.queue_size;
+        else if (token == "hash") is >> options.hash_mb;
+        else if (token == "depth") is >> options.limits.depth;
+        else if (token == "socket") is >> options.socket_path;
+    }
+    // The default depth bounds every request that sets no limit.
+    options.limits.depth = std::clamp(options.limits.depth, 1, Search::MAX_PLY - 1);
+    Serve::run(options);
+}
+
+// gensfen <out> [count <n>] [threads <t>] [nodes <n>] [random <plies>] [hash <mb>] [seed <n>]
+//               [resign <cp>] [maxply <n>]
+static void handle_gensfen(std::istringstream& is) {
+    Gensfen::Options options;
+    options.threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    std::string token;
+    if (!(is >> options.output_path)) {
+        std::cout << "info string Usage: gensfen <out> [count <n>] [threads <t>] [nodes <n>] [random <plies>]"
+                  << std::endl;
+        return;
+    }
+    while (is >> token) {
+        if (token == "count") is >> options.count;
+        else if (token == "threads") is >> options.threads;
+        else if (token == "nodes") is >> options.nodes;
+        else if (token == "random") is >> options.random_plies;
+        else if (token == "hash") is >> options.hash_mb;
+        else if (token == "seed") is >> options.seed;
+        else if (token == "resign") is >> options.resign_score;
+        else if (token == "maxply") is >> options.max_ply;
+    }
+    Gensfen::run(options);
+}
+
+// tune <dataset> [epochs <n>] [threads <t>] [lr <cp>] [lambda <x>] [output <file>]
+static void handle_tune(std::istringstream& is) {
+    Tune::Options options;
+    options.threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    std::string token;
+    if (!(is >> options.dataset_path)) {
+        std::cout << "info string Usage: tune <dataset> [epochs <n>] [threads <t>] [lr <cp>] [lambda <x>]"
+                  << " [output <file>]" << std::endl;
+        return;
+    }
+    while (is >> token) {
+        if (token == "epochs") is >> options.epochs;
+        else if (token == "threads") is >> options.threads;
+        else if (token == "lr") is >> options.learning_rate;
+        else if (token == "lambda") is >> options.lambda;
+        else if (token == "output") is >> options.output_path;
+    }
+    Tune::run(options);
+}
+
+// stats [json [<file>]]
+// Shows the statistics of the last search or perft run, or dumps them as JSON
+// to stdout or a file.
+static void handle_stats(Session& session, std::istringstream& is) {
+    if (!Stats::ENABLED) {
+        std::cout << "info string Statistics are not compiled in; configure with -DAETHERCHESS_STATS=ON"
+                  << std::endl;
+        return;
+    }
+    std::string token, path;
+    if (!(is >> token)) {
+        Stats::print_info(std::cout, session.stats);
+        return;
+    }
+    if (token != "json") {
+        std::cout << "info string Usage: stats [json [<file>]]" << std::endl;
+        return;
+    }
+    if (!(is >> path)) {
+        std::cout << Stats::to_json(session.stats) << std::endl;
+        return;
+    }
+    std::ofstream out(path);
+    if (!(out << Stats::to_json(session.stats) << '\n')) std::cout << "info string Cannot write " << path << std::endl;
+}
+
+// hash save <file> | hash load <file>
+// Saves the transposition table, or replaces it with a saved one, which then
+// sets the table size.
+static void handle_hash(Session& session, std::istringstream& is) {
+    std::string action, path, error;
+    if (!(is >> action >> path) || (action != "save" && action != "load")) {
+        std::cout << "info string Usage: hash save <file> | hash load <file>" << std::endl;
+        return;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    const bool ok = action == "save" ? session.tt.save(path, error) : session.tt.load(path, error);
+    if (!ok) {
+        std::cout << "info string " << error << std::endl;
+        return;
+    }
+    const int64_t ms =
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    if (action == "load") session.hash_mb = std::max<size_t>(1, session.tt.size_mb());
+    std::cout << "info string " << (action == "save" ? "Saved " : "Loaded ") << path << " in " << ms
+              << " ms, Hash " << session.tt.memory_info() << std::endl;
+}
+
+// epd <file> [depth <d>] [nodes <n>] [movetime <ms>] [threads <t>] [hash <mb>]
+static void handle_epd(std::istringstream& is) {
+    std::string path, token;
+    is >> path;
+    EPD::SuiteOptions options;
+    options.limits.movetime_ms = 1000;
+    options.threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    while (is >> token) {
+        if (token == "depth") { is >> options.limits.depth; options.limits.movetime_ms = 0; }
+        else if (token == "nodes") { is >> options.limits.nodes; options.limits.movetime_ms = 0; }
+        else if (token == "movetime") is >> options.limits.movetime_ms;
+        else if (token == "threads") is >> options.threads;
+        else if (token == "hash") is >> options.hash_mb;
+    }
+    EPD::run_suite(path, options);
+}
+
+// fenbench <file>
+// Parses every FEN/EPD line of a file straight out of a memory mapping and
+// reports invalid records and the parsing throughput.
+static void handle_fenbench(std::istringstream& is) {
+    std::string path;
+    is >> path;
+    MappedFile file;
+    if (!file.open(path)) {
+        std::cout << "info string Cannot open " << path << std::endl;
+        return;
+    }
+
+    Position pos;
+    uint64_t parsed = 0, invalid = 0, line_number = 0;
+    const auto start = std::chrono::steady_clock::now();
+
+    std::string_view rest = file.view();
+    while (!rest.empty()) {
+        const std::string_view line = IO::next_line(rest);
+        ++line_number;
+        if (line.empty()) continue;
+
+        ++parsed;
+        if (const FenResult result = pos.set_from_fen(line); !result) {
+            if (++invalid <= 10) {
+                std::cout << "info string Line " << line_number << ", offset " << result.offset
+                          << ": " << fen_error_string(result.error) << std::endl;
+            }
+        }
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Records: " << parsed << "\nInvalid: " << invalid
+              << "\nFENs/second: " << static_cast<uint64_t>(parsed / std::max(seconds, 1e-9)) << std::endl;
+}
+
+// dataset pack <in.fen> <out.bin> | dataset verify <file.bin> [threads <t>]
+static void handle_dataset(std::istringstream& is) {
+    std::string action, path, token;
+    is >> action >> path;
+    if (action == "pack") {
+        std::string output;
+        is >> output;
+        Dataset::pack(path, output);
+    } else if (action == "verify") {
+        int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        while (is >> token) {
+            if (token == "threads") is >> threads;
+        }
+        Dataset::verify(path, threads);
+    } else {
+        std::cout << "info string Usage: dataset pack <in> <out> | dataset verify <file> [threads <t>]" << std::endl;
+    }
+}
+
+// pgn <file> [threads <t>] [san]
+static void handle_pgn(std::istringstream& is) {
+    std::string path, token;
+    is >> path;
+    int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    bool check_san = false;
+    while (is >> token) {
+        if (token == "threads") is >> threads;
+        else if (token == "san") check_san = true;
+    }
+    Games::scan(path, threads, check_san);
+}
+
+// book
+// Lists the book moves for the current position with their weights.
+static void handle_book(Session& session) {
+    if (!session.book.is_open()) {
+        std::cout << "info string No book loaded" << std::endl;
+        return;
+    }
+    Polyglot::BookMove moves[Polyglot::MAX_BOOK_MOVES];
+    const int count = session.book.probe(session.pos, moves);
+    uint32_t total = 0;
+    for (int i = 0; i < count; ++i) total += moves[i].weight;
+    std::cout << "Key: " << std::hex << Polyglot::key(session.pos) << std::dec << "\n";
+    for (int i = 0; i < count; ++i) {
+        std::cout << Perft::move_to_string(moves[i].move) << " weight " << moves[i].weight << " ("
+                  << (total ? 100.0 * moves[i].weight / total : 0.0) << "%)\n";
+    }
+    std::cout << count << " book moves" << std::endl;
+}
+
+// tree build <pgn> <out> [threads <t>] [plies <n>] [memory <mb>] [mingames <n>] | tree probe <index>
+static void handle_tree(Session& session, std::istringstream& is) {
+    std::string action, token;
+    is >> action;
+    if (action == "build") {
+        OpeningTree::BuildOptions options;
+        is >> options.pgn_path >> options.output_path;
+        options.threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        while (is >> token) {
+            if (token == "threads") is >> options.threads;
+            else if (token == "plies") is >> options.max_plies;
+            else if (token == "memory") is >> options.memory_mb;
+            else if (token == "mingames") is >> options.min_games;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        OpeningTree::BuildStats stats;
+        std::string error;
+        if (!OpeningTree::build(options, stats, error)) {
+            std::cout << "info string " << error << std::endl;
+            return;
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Games: " << stats.games << "\nEdges: " << stats.edges << "\nRuns: " << stats.runs
+                  << "\nEntries: " << stats.entries << "\nGames/second: "
+                  << static_cast<uint64_t>(stats.games / std::max(seconds, 1e-9)) << std::endl;
+    } else if (action == "probe") {
+        std::string path, error;
+        is >> path;
+        OpeningTree::Index index;
+        if (!index.open(path, error)) {
+            std::cout << "info string " << error << std::endl;
+            return;
+        }
+        const std::span<const OpeningTree::Entry> entries = index.lookup(session.pos.hash_key);
+        for (const OpeningTree::Entry& e : entries) {
+            std::cout << Perft::move_to_string(e.move) << " games " << e.games << " +" << e.wins << " ="
+                      << e.draws << " -" << e.losses() << " score " << static_cast<int>(100 * e.score() + 0.5)
+                      << "%\n";
+        }
+        std::cout << entries.size() << " moves" << std::endl;
+    } else {
+        std::cout << "info string Usage: tree build <pgn> <out> [threads <t>] [plies <n>] [memory <mb>]"
+                     " [mingames <n>] | tree probe <index>" << std::endl;
+    }
+}
+
+// tb generate <dir> [pieces <n>] [threads <t>] | tb probe | tb verify <table> [threads <t>]
+static void handle_tb(Session& session, std::istringstream& is) {
+    std::string action, token;
+    is >> action;
+    if (action == "generate") {
+        Tablebase::GenerateOptions options;
+        is >> options.directory;
+        options.threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        while (is >> token) {
+            if (token == "pieces") is >> options.max_pieces;
+            else if (token == "threads") is >> options.threads;
+        }
+        std::string error;
+        if (!Tablebase::generate(options, error)) std::cout << "info string " << error << std::endl;
+    } else if (action == "verify") {
+        std::string name, error;
+        int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        is >> name;
+        while (is >> token) {
+            if (token == "threads") is >> threads;
+        }
+        if (!Tablebase::verify(name, threads, error)) std::cout << "info string " << error << std::endl;
+    } else if (action == "probe") {
+        Position& pos = session.pos;
+        int wdl, dtm;
+        if (!Tablebase::probe_dtm(pos, wdl, dtm)) {
+            std::cout << "info string Position not in the tablebases" << std::endl;
+            return;
+        }
+
+        // The best move wins fastest, or loses slowest.
+        MoveList moves;
+        MoveGenerator::generate_moves(pos, moves);
+        Move best = MOVE_NONE;
+        int best_rank = 0;
+        for (int i = 0; i < moves.count; ++i) {
+            const Move m = moves.moves[i];
+            if (!pos.make_move(m)) continue;
+            int child_wdl, child_dtm;
+            if (Tablebase::probe_dtm(pos, child_wdl, child_dtm)) {
+                const int rank = child_wdl == Tablebase::WDL_LOSS ? 1000 - child_dtm
+                                 : child_wdl == Tablebase::WDL_DRAW ? 0 : -1000 + child_dtm;
+                if (best == MOVE_NONE || rank > best_rank) {
+                    best = m;
+                    best_rank = rank;
+                }
+            }
+            pos.unmake_move(m);
+        }
+        std::cout << (wdl == Tablebase::WDL_WIN ? "win" : wdl == Tablebase::WDL_LOSS ? "loss" : "draw")
+                  << " dtm " << dtm << " bestmove " << (best ? Perft::move_to_string(best) : "none") << std::endl;
+    } else {
+        std::cout << "info string Usage: tb generate <dir> [pieces <n>] [threads <t>] | tb probe"
+                     " | tb verify <table> [threads <t>]" << std::endl;
+    }
+}
+
+// Parses the value of the spin option 'name' and clamps it to [min, max].
+// Returns false, with an "info string" for the GUI, if it is not a number.
+static bool parse_spin(const std::string& name, const std::string& value, int min, int max, int& result) {
+    const char* const last = value.data() + value.find_last_not_of(" \t\r") + 1;
+    int parsed = 0;
+    const auto [end, ec] = std::from_chars(value.data(), last, parsed);
+    if (value.empty() || ec != std::errc() || end != last) {
+        std::cout << "info string Ignoring " << name << " value '" << value << "', not a number" << std::endl;
+        return false;
+    }
+    result = std::clamp(parsed, min, max);
+    return true;
+}
+
+static bool execute(Session& session, const std::string& line) {
+    std::istringstream is(line);
+    std::string token;
+    is >> token;
+
+    if (token == "quit") {
+        session.wait_for_search(true);
+        return false;
+    }
+    if (token == "stop") {
+        session.wait_for_search(true);
+    } else if (token == "uci") {
+        std::cout << "id name AetherChess" << std::endl;
+        std::cout << "id author AetherChess developers" << std::endl;
+        std::cout << "option name Hash type spin default 16 min 1 max 65536" << std::endl;
+        std::cout << "option name MateHash type spin default 16 min 1 max 65536" << std::endl;
+        std::cout << "option name MoveOverhead type spin default 10 min 0 max 5000" << std::endl;
+        std::cout << "option name Book type string default <empty>" << std::endl;
+        std::cout << "option name TablebasePath type string default <empty>" << std::endl;
+        std::cout << "info string Hash " << session.tt.memory_info() << std::endl;
+        std::cout << "info string Attack tables " << Attacks::memory_info() << std::endl;
+        std::cout << "uciok" << std::endl;
+    } else if (token == "isready") {
+        std::cout << "readyok" << std::endl;
+    } else if (token == "setoption") {
+        std::string name, value;
+        is >> token >> name >> token; // name <id> value <x>
+        std::getline(is >> std::ws, value);
+        session.wait_for_search(true);
+        if (name == "Hash") {
+            int mb = 0;
+            if (!parse_spin(name, value, 1, 65536, mb)) return true;
+            session.mate_solver.release();
+            try {
+                session.tt.resize(static_cast<size_t>(mb));
+                session.hash_mb = static_cast<size_t>(mb);
+            } catch (const std::bad_alloc&) {
+                // The old table is already released; allocate it again.
+                std::cout << "info string Cannot allocate " << mb << " MB, keeping " << session.hash_mb << " MB"
+                          << std::endl;
+                session.tt.resize(session.hash_mb);
+            }
+            std::cout << "info string Hash " << session.tt.memory_info() << std::endl;
+        } else if (name == "MateHash") {
+            int mb = 0;
+            if (parse_spin(name, value, 1, 65536, mb)) {
+                session.mate_hash_mb = static_cast<size_t>(mb);
+                session.mate_solver.release();
+            }
+        } else if (name == "MoveOverhead") {
+            int ms = 0;
+            if (parse_spin(name, value, 0, 5000, ms)) session.move_overhead_ms = ms;
+        } else if (name == "TablebasePath") {
+            const int loaded = Tablebase::init(value);
+            std::cout << "info string Loaded " << loaded << " tablebase files, up to "
+                      << Tablebase::max_pieces() << " pieces" << std::endl;
+        } else if (name == "Book") {
+            session.book.close();
+            if (value != "<empty>" && !value.empty() && !session.book.open(value)) {
+                std::cout << "info string Cannot open book " << value << std::endl;
+            }
+        }
+    } else if (token == "ucinewgame") {
+        session.wait_for_search(true);
+        session.pos.set_from_fen(START_FEN);
+        session.tt.clear();
+        session.mate_solver.release();
+    } else if (token == "position") {
+        session.wait_for_search(true);
+        handle_position(session.pos, is);
+    } else if (token == "go") {
+        session.wait_for_search(true);
+        handle_go(session, is);
+    } else if (token == "serve") {
+        session.wait_for_search(true);
+        handle_serve(is);
+        return false;
+    } else if (token == "gensfen") {
+        session.wait_for_search(true);
+        handle_gensfen(is);
+    } else if (token == "tune") {
+        session.wait_for_search(true);
+        handle_tune(is);
+    } else if (token == "stats") {
+        session.wait_for_search(true);
+        handle_stats(session, is);
+    } else if (token == "hash") {
+        session.wait_for_search(true);
+        handle_hash(session, is);
+    } else if (token == "epd") {
+        handle_epd(is);
+    } else if (token == "dataset") {
+        handle_dataset(is);
+    } else if (token == "book") {
+        handle_book(session);
+    } else if (token == "tb") {
+        session.wait_for_search(true);
+        handle_tb(session, is);
+    } else if (token == "tree") {
+        handle_tree(session, is);
+    } else if (token == "pgn") {
+        handle_pgn(is);
+    } else if (token == "fenbench") {
+        handle_fenbench(is);
+    } else if (!token.empty()) {
+        std::cout << "Unknown command: " << line << std::endl;
+    }
+    return true;
+}
+
+void loop(int argc, char* argv[]) {
+    auto session = std::make_unique<Session>();
+
+    if (argc > 1) {
+        std::string command;
+        for (int i = 1; i < argc; ++i) command += std::string(argv[i]) + " ";
+        execute(*session, command);
+        session->wait_for_search(false);
+        return;
+    }
+
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        if (!execute(*session, line)) break;
+    }
+    session->wait_for_search(true);
+}
+
+} // namespace UCI
+} // namespace aetherchess
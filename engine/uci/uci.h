@@ -0,0 +1,19 @@
+#pragma once
+
+#include "../core/position.h"
+#include <string>
+
+namespace aetherchess {
+namespace UCI {
+
+// Reads UCI commands from stdin until "quit". If command-line arguments are
+// given, they are executed as a single command instead and the loop exits.
+void loop(int argc, char* argv[]);
+
+// Converts a move in UCI coordinate notation (e.g. "e2e4", "e7e8q") to the
+// engine's encoding. The flags are derived from the board and the result is
+// validated, so MOVE_NONE is returned for anything illegal in 'pos'.
+Move to_move(const Position& pos, const std::string& str);
+
+} // namespace UCI
+} // namespace aetherchess
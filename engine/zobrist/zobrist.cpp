@@ -1,5 +1,7 @@
 #include "zobrist.h"
+#include "movegen/attacks.h"
 #include <cstdint>
+#include <utility>
 
 namespace aetherchess {
 namespace Zobrist {
@@ -9,6 +11,8 @@ uint64_t piece_keys[2][6][64];
 uint64_t black_to_move_key;
 uint64_t castling_keys[16];
 uint64_t en_passant_keys[8];
+uint64_t cuckoo_keys[8192];
+Move cuckoo_moves[8192];
 
 // A simple pseudo-random number generator to ensure that the keys are
 // the same every time the engine is run.
@@ -50,5 +54,49 @@ void init() {
     }
 }
 
+uint64_t checksum() {
+    // FNV-1a over the keys in declaration order.
+    uint64_t sum = 0xcbf29ce484222325;
+    auto mix = [&sum](uint64_t key) { sum = (sum ^ key) * 0x100000001b3; };
+    for (const auto& color : piece_keys) {
+        for (const auto& piece : color) {
+            for (uint64_t key : piece) mix(key);
+        }
+    }
+    mix(black_to_move_key);
+    for (uint64_t key : castling_keys) mix(key);
+    for (uint64_t key : en_passant_keys) mix(key);
+    return sum;
+}
+
+void init_cuckoo() {
+    for (int i = 0; i < 8192; ++i) {
+        cuckoo_keys[i] = 0;
+        cuckoo_moves[i] = 0;
+    }
+
+    for (int c = 0; c < 2; ++c) {
+        for (int pt = static_cast<int>(PieceType::KNIGHT); pt <= static_cast<int>(PieceType::KING); ++pt) {
+            for (int s1 = 0; s1 < 64; ++s1) {
+                for (int s2 = s1 + 1; s2 < 64; ++s2) {
+                    const Bitboard attacks = Attacks::get_piece_attacks(static_cast<PieceType>(pt), static_cast<Square>(s1), 0ULL);
+                    if (!(attacks & (1ULL << s2))) continue;
+
+                    // Insert with cuckoo hashing, evicting into the other slot until one is free.
+                    Move move = Moves::create(static_cast<Square>(s1), static_cast<Square>(s2));
+                    uint64_t key = piece_keys[c][pt][s1] ^ piece_keys[c][pt][s2] ^ black_to_move_key;
+                    int i = cuckoo_h1(key);
+                    while (true) {
+                        std::swap(cuckoo_keys[i], key);
+                        std::swap(cuckoo_moves[i], move);
+                        if (move == 0) break;
+                        i = (i == cuckoo_h1(key)) ? cuckoo_h2(key) : cuckoo_h1(key);
+                    }
+                }
+            }
+        }
+    }
+}
+
 } // namespace Zobrist
 } // namespace aetherchess
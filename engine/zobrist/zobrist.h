@@ -24,8 +24,26 @@ extern uint64_t castling_keys[16];
 extern uint64_t en_passant_keys[8];
 
 // Initializes all Zobrist keys with pseudo-random 64-bit numbers.
-// Must be called once at program startup.
+// Called once, through aetherchess::init() (core/init.h).
 void init();
 
+// A checksum of all the keys above, which identifies the seed and the key
+// layout. Saved hash tables carry it, since their keys mean nothing to a build
+// that hashes positions differently.
+uint64_t checksum();
+
+// Cuckoo tables of all reversible piece moves on an empty board, keyed by the
+// XOR of the move's piece keys and the side key. Used to detect that a single
+// move could bring back an earlier position (an upcoming repetition).
+extern uint64_t cuckoo_keys[8192];
+extern Move cuckoo_moves[8192];
+
+inline int cuckoo_h1(uint64_t key) { return key & 0x1FFF; }
+inline int cuckoo_h2(uint64_t key) { return (key >> 16) & 0x1FFF; }
+
+// Fills the cuckoo tables. Called after init() and Attacks::init(), through
+// aetherchess::init().
+void init_cuckoo();
+
 } // namespace Zobrist
 } // namespace aetherchess